@@ -82,130 +82,311 @@ namespace m328p
         };
         
         /**
-        @brief Initialization
-        @param referenceSelection Selected ADC reference voltage
-        @param ePrescalerSelect Selected ADC clock pre-scaler
-        @param bInterruptEnable Flag indicating ADC interrupt on conversion complete is enabled
-        @param autoTriggerEnable Flag indicating ADC is triggered automatically
-        @param autoTriggerSource Selected source for auto trigger
-        @param enableADC0 Flag indication ADC0 pin is configured as analog input pin,
-        @param enableADC1 Flag indication ADC1 pin is configured as analog input pin,
-        @param enableADC2 Flag indication ADC2 pin is configured as analog input pin,
-        @param enableADC3 Flag indication ADC3 pin is configured as analog input pin,
-        @param enableADC4 Flag indication ADC4 pin is configured as analog input pin,
-        @param enableADC5 Flag indication ADC5 pin is configured as analog input pin)
-        */
-        static void init(
-        const ReferenceSelection referenceSelection,
-        const PrescalerSelect ePrescalerSelect,
-        const bool bInterruptEnable,
-        const bool autoTriggerEnable,
-        const AutoTriggerSource autoTriggerSource,
-        const bool enableADC0,
-        const bool enableADC1,
-        const bool enableADC2,
-        const bool enableADC3,
-        const bool enableADC4,
-        const bool enableADC5)
-        {
-            // ADMUX register
-            REFS::write(referenceSelection);
-            ADLAR_bit::set(); // Left-align conversion result
+        @brief Reader for A/D conversion results of given type
+        The result type is a compile-time property of the reader: The reader selects the matching result alignment on
+        initialization and reads results in the same format, so the alignment and the type of the results read cannot disagree.
+        uint8_t selects left-aligned results, so the 8 most significant bits are read from ADCH only.
+        uint16_t selects right-aligned results, so the 10-bit result is read from ADC without shifting
 
-            // ADC Control and Status Register A
-            ADEN_bit::write(true);
-            ADATE_bit::write(autoTriggerEnable);
-            ADIE_bit::write(bInterruptEnable);
-            ADPS::write(ePrescalerSelect);
+        Usage:
+        @code
+        typedef m328p::ADConverter::Reader<uint16_t> Reader;
 
-            // ADC Control and Status Register B
-            ADTS::write(autoTriggerSource);
+        Reader::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::PrescalerSelect::DIV_128,
+        false, false, m328p::ADConverter::AutoTriggerSource::FREE_RUN, true, false, false, false, false, false);
 
-            // Digital Input Disable Register 0
-            ADC0D_Bit::write(enableADC0);
-            ADC1D_Bit::write(enableADC1);
-            ADC2D_Bit::write(enableADC2);
-            ADC3D_Bit::write(enableADC3);
-            ADC4D_Bit::write(enableADC4);
-            ADC5D_Bit::write(enableADC5);
-        }
+        Reader::Pin<0>::startConversion();
+        Reader::Pin<0>::wait();
+        const uint16_t value = Reader::Pin<0>::read();
+        @endcode
 
-        /**
-        @brief Analog input pin driver class implementing high-level ADC access
-        @tparam t_channelIdx Corresponding ADC channel index 0..7
-        @note The ADC module has to initialized beforehand using the parent ADC driver class interface
+        @tparam Result Type of AD conversion result (here: 8 Bit or 16 Bit unsigned)
         */
-        template <uint8_t t_channelIdx>
-        class Pin
+        template <typename Result>
+        class Reader
         {
             public:
-            
+
             /**
-            @brief Read the AD conversion result in the desired resolution
-            @tparam Result Type of AD conversion result (here: 8 Bit or 16 Bit unsigned)
-            @result AD conversion result
+            @brief Initialization. The result alignment matching the result type is selected
+            @param referenceSelection Selected ADC reference voltage
+            @param ePrescalerSelect Selected ADC clock pre-scaler
+            @param bInterruptEnable Flag indicating ADC interrupt on conversion complete is enabled
+            @param autoTriggerEnable Flag indicating ADC is triggered automatically
+            @param autoTriggerSource Selected source for auto trigger
+            @param enableADC0 Flag indication ADC0 pin is configured as analog input pin,
+            @param enableADC1 Flag indication ADC1 pin is configured as analog input pin,
+            @param enableADC2 Flag indication ADC2 pin is configured as analog input pin,
+            @param enableADC3 Flag indication ADC3 pin is configured as analog input pin,
+            @param enableADC4 Flag indication ADC4 pin is configured as analog input pin,
+            @param enableADC5 Flag indication ADC5 pin is configured as analog input pin)
             */
-            template <typename Result>
-            static Result read()
+            static void init(
+            const ReferenceSelection referenceSelection,
+            const PrescalerSelect ePrescalerSelect,
+            const bool bInterruptEnable,
+            const bool autoTriggerEnable,
+            const AutoTriggerSource autoTriggerSource,
+            const bool enableADC0,
+            const bool enableADC1,
+            const bool enableADC2,
+            const bool enableADC3,
+            const bool enableADC4,
+            const bool enableADC5)
             {
-                return ADConverter::template read<Result>();
+                selectAlignment();
+                ADConverter::init(
+                referenceSelection,
+                ePrescalerSelect,
+                bInterruptEnable,
+                autoTriggerEnable,
+                autoTriggerSource,
+                enableADC0,
+                enableADC1,
+                enableADC2,
+                enableADC3,
+                enableADC4,
+                enableADC5);
             }
-            
+
             /**
-            @brief Start A/D conversion on the selected pin
-            @note This method will wait synchronously until the ADC is ready
+            @brief Select the result alignment matching the result type
+            @note Selected by init(). Only required if another reader has changed the alignment in the meantime
             */
-            static void startConversion() __attribute__((always_inline))
+            static void selectAlignment() __attribute__((always_inline))
             {
-                select();
-                ADConverter::startConversion();
+                ADConverter::template selectAlignment<Result>();
             }
-            
+
             /**
-            @brief  Wait synchronously until the ADC is ready
+            @brief Read the A/D conversion result
+            @result AD conversion result: 8 most significant bits for uint8_t, right-aligned 10-bit result for uint16_t
             */
-            static void wait() __attribute__((always_inline))
+            [[nodiscard]] static Result read() __attribute__((always_inline))
             {
-                ADConverter::wait();
+                return ADConverter::template read<Result>();
             }
-            
-            private:
-            
-            // Select the channel on the ADC
-            static void select() __attribute__((always_inline))
+
+            /**
+            @brief Analog input pin driver class implementing high-level ADC access
+            @tparam t_channelIdx Corresponding ADC channel index, see ChannelSelection
+            @note The ADC module has to initialized beforehand using Reader::init()
+            */
+            template <uint8_t t_channelIdx>
+            class Pin
             {
-                static_assert(t_channelIdx <= 8, "Invalid channel: Selected channel index >= 8!");
-                ADConverter::selectChannel(static_cast<ChannelSelection>(t_channelIdx));
-            }
-        };
+                static_assert(
+                t_channelIdx <= static_cast<uint8_t>(ChannelSelection::ADC8) ||
+                t_channelIdx == static_cast<uint8_t>(ChannelSelection::VBG) ||
+                t_channelIdx == static_cast<uint8_t>(ChannelSelection::GND),
+                "Invalid channel: Valid channel indices are 0..8 (ADC0..ADC7, temperature sensor), 14 (VBG) and 15 (GND)!");
 
-        private:
+                public:
 
-        // Read A/D conversion result in the desired resolution
-        template <typename Result>
-        static Result read();
+                /**
+                @brief Read the AD conversion result
+                @result AD conversion result
+                */
+                [[nodiscard]] static Result read() __attribute__((always_inline))
+                {
+                    return Reader::read();
+                }
+
+                /**
+                @brief Start A/D conversion on the selected pin
+                @note This method will wait synchronously until the ADC is ready
+                */
+                static void startConversion() __attribute__((always_inline))
+                {
+                    ADConverter::selectChannel(static_cast<ChannelSelection>(t_channelIdx));
+                    ADConverter::startConversion();
+                }
+
+                /**
+                @brief  Wait synchronously until the ADC is ready
+                */
+                static void wait() __attribute__((always_inline))
+                {
+                    ADConverter::wait();
+                }
+            };
+        };
         
-        // Select ADC input channel
+        /**
+        @brief Select the ADC input channel
+        @param channelSelection Selected input channel
+        @note If a conversion is in progress, the new channel is used for the next conversion
+        */
         static void selectChannel(const ChannelSelection channelSelection) __attribute__((always_inline))
         {
             // Select ADC channel
             MUX::write(channelSelection);
         }
 
-        // Start A/D conversion
+        /**
+        @brief Get the selected ADC input channel
+        @result Selected input channel
+        */
+        [[nodiscard]] static ChannelSelection getChannel() __attribute__((always_inline))
+        {
+            return MUX::read();
+        }
+
+        /**
+        @brief Select the ADC reference voltage
+        @param referenceSelection Selected ADC reference voltage
+        @note The reference voltage needs time to settle, especially with a capacitor at the AREF pin. The first conversion
+        after a change may be inaccurate
+        */
+        static void selectReference(const ReferenceSelection referenceSelection) __attribute__((always_inline))
+        {
+            REFS::write(referenceSelection);
+        }
+
+        /**
+        @brief Get the selected ADC reference voltage
+        @result Selected reference voltage
+        */
+        [[nodiscard]] static ReferenceSelection getReference() __attribute__((always_inline))
+        {
+            return REFS::read();
+        }
+
+        /**
+        @brief Check if the result alignment is left-aligned
+        @result Flag indicating results are left-aligned (uint8_t) rather than right-aligned (uint16_t)
+        */
+        [[nodiscard]] static bool isLeftAligned() __attribute__((always_inline))
+        {
+            return ADLAR_bit::read();
+        }
+
+        /**
+        @brief Start A/D conversion on the selected channel
+        */
         static void startConversion() __attribute__((always_inline))
         {
             // Start A/D conversion by setting ADSC
             ADSC_bit::set();
         }
         
-        // Wait for AD conversion to complete
+        /**
+        @brief Wait synchronously until the ADC is ready
+        */
         static void wait() __attribute__((always_inline))
         {
             // AD conversion is in progress while ADSC is set
             while (ADSC_bit::read());
         }
 
+        /**
+        @brief Enable or disable auto triggering
+        @param enable Flag indicating ADC is triggered automatically by the source selected in init()
+        */
+        static void enableAutoTrigger(const bool enable) __attribute__((always_inline))
+        {
+            ADATE_bit::write(enable);
+        }
+
+        /**
+        @brief Check if auto triggering is enabled
+        @result Flag indicating ADC is triggered automatically
+        */
+        [[nodiscard]] static bool isAutoTriggerEnabled() __attribute__((always_inline))
+        {
+            return ADATE_bit::read();
+        }
+
+        /**
+        @brief Enable or disable the conversion complete interrupt
+        @param enable Flag indicating ADC interrupt on conversion complete is enabled
+        */
+        static void enableInterrupt(const bool enable) __attribute__((always_inline))
+        {
+            ADIE_bit::write(enable);
+        }
+
+        /**
+        @brief Check if the conversion complete interrupt is enabled
+        @result Flag indicating ADC interrupt on conversion complete is enabled
+        */
+        [[nodiscard]] static bool isInterruptEnabled() __attribute__((always_inline))
+        {
+            return ADIE_bit::read();
+        }
+
+        /**
+        @brief Enable or disable the ADC
+        @param enable Flag indicating the ADC is enabled. A conversion in progress is terminated when the ADC is disabled
+        */
+        static void enable(const bool enable) __attribute__((always_inline))
+        {
+            ADEN_bit::write(enable);
+        }
+
+        /**
+        @brief Check if the ADC is enabled
+        @result Flag indicating the ADC is enabled
+        */
+        [[nodiscard]] static bool isEnabled() __attribute__((always_inline))
+        {
+            return ADEN_bit::read();
+        }
+
+        /**
+        @brief Check if a conversion is in progress
+        @result Flag indicating ADSC is set
+        */
+        [[nodiscard]] static bool isBusy() __attribute__((always_inline))
+        {
+            return ADSC_bit::read();
+        }
+
+        private:
+
+        // Initialization without result alignment, which is selected by Reader::init()
+        static void init(
+        const ReferenceSelection referenceSelection,
+        const PrescalerSelect ePrescalerSelect,
+        const bool bInterruptEnable,
+        const bool autoTriggerEnable,
+        const AutoTriggerSource autoTriggerSource,
+        const bool enableADC0,
+        const bool enableADC1,
+        const bool enableADC2,
+        const bool enableADC3,
+        const bool enableADC4,
+        const bool enableADC5)
+        {
+            // ADMUX register
+            REFS::write(referenceSelection);
+
+            // ADC Control and Status Register A
+            ADEN_bit::write(true);
+            ADATE_bit::write(autoTriggerEnable);
+            ADIE_bit::write(bInterruptEnable);
+            ADPS::write(ePrescalerSelect);
+
+            // ADC Control and Status Register B
+            ADTS::write(autoTriggerSource);
+
+            // Digital Input Disable Register 0
+            ADC0D_Bit::write(enableADC0);
+            ADC1D_Bit::write(enableADC1);
+            ADC2D_Bit::write(enableADC2);
+            ADC3D_Bit::write(enableADC3);
+            ADC4D_Bit::write(enableADC4);
+            ADC5D_Bit::write(enableADC5);
+        }
+
+        // Select the result alignment matching the type of AD conversion result. Only accessible via Reader
+        template <typename Result>
+        static void selectAlignment() __attribute__((always_inline));
+
+        // Read the A/D conversion result in the format matching the selected alignment. Only accessible via Reader
+        template <typename Result>
+        static Result read();
+
         // Reference Selection Bits
         typedef BitGroupInRegister<ADMUX, REFS0, REFS1, ReferenceSelection> REFS;
 
@@ -252,6 +433,20 @@ namespace m328p
     };
 
     // template method specializations
+    template<>
+    inline void ADConverter::selectAlignment<uint8_t>()
+    {
+        // Left-align conversion result
+        ADLAR_bit::set();
+    }
+
+    template<>
+    inline void ADConverter::selectAlignment<uint16_t>()
+    {
+        // Right-align conversion result
+        ADLAR_bit::clear();
+    }
+
     template<>
     inline uint8_t ADConverter::read<uint8_t>()
     {
@@ -262,7 +457,7 @@ namespace m328p
     template<>
     inline uint16_t ADConverter::read<uint16_t>()
     {
-        // Read 16 bit result
+        // Read 10 bit result (right-aligned)
         return ADC::read();
     }
 }
@@ -0,0 +1,178 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCCLOCK_H
+#define M328P_ADCCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_ADC.h"
+
+namespace m328p
+{
+    ///@brief ADC operating mode defining the valid ADC clock range
+    enum class ADCMode : uint8_t
+    {
+        PRECISE_10BIT, // ADC clock 50 kHz to 200 kHz for full 10-bit accuracy. Use with ADConverter::Reader<uint16_t>::init()
+        FAST_8BIT // ADC clock 50 kHz to 1 MHz for 8-bit results at up to 4x the throughput. Use with ADConverter::Reader<uint8_t>::init()
+    };
+
+    /**
+    @brief Compile-time selection of the ADC clock pre-scaler
+    Without a target sample rate, the fastest ADC clock within the range of the selected mode is chosen for maximum throughput.
+    With a target sample rate, the slowest ADC clock within this range reaching the target is chosen, as a slower ADC clock
+    improves accuracy. Targets which cannot be reached are rejected at compile time.
+
+    Usage:
+    @code
+    typedef m328p::ADCClock<F_CPU, m328p::ADCMode::FAST_8BIT> Clock;
+    static_assert(Clock::getSampleRate() >= 50000, "Too slow!");
+
+    m328p::ADConverter::Reader<uint8_t>::init(m328p::ADConverter::ReferenceSelection::AVCC, Clock::getPrescalerSelect(),
+    true, true, m328p::ADConverter::AutoTriggerSource::FREE_RUN, true, false, false, false, false, false);
+    @endcode
+
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam t_mode ADC operating mode
+    @tparam t_sampleRate Minimum number of conversions per second in free running mode, or 0 for maximum throughput
+    */
+    template <uint32_t t_cpuClock, ADCMode t_mode, uint32_t t_sampleRate = 0>
+    class ADCClock
+    {
+        public:
+
+        /**
+        @brief Get the lower limit of the ADC clock
+        @result Minimum ADC clock frequency in Hz
+        */
+        static constexpr uint32_t getMinClock()
+        {
+            return 50000UL;
+        }
+
+        /**
+        @brief Get the upper limit of the ADC clock in the selected mode
+        @result Maximum ADC clock frequency in Hz
+        */
+        static constexpr uint32_t getMaxClock()
+        {
+            return (t_mode == ADCMode::FAST_8BIT) ? 1000000UL : 200000UL;
+        }
+
+        /**
+        @brief Get the selected ADC clock pre-scaler
+        @result ADC clock pre-scaler
+        */
+        static constexpr ADConverter::PrescalerSelect getPrescalerSelect()
+        {
+            return static_cast<ADConverter::PrescalerSelect>(c_prescalerCode);
+        }
+
+        /**
+        @brief Get the selected ADC clock division factor
+        @result Division factor (2..128)
+        */
+        static constexpr uint8_t getPrescaler()
+        {
+            return getPrescaler(c_prescalerCode);
+        }
+
+        /**
+        @brief Get the resulting ADC clock
+        @result ADC clock frequency in Hz (rounded down)
+        */
+        static constexpr uint32_t getClock()
+        {
+            return t_cpuClock / getPrescaler();
+        }
+
+        /**
+        @brief Get the number of conversions per second in free running mode
+        @result Sample rate in Hz (rounded down). A conversion takes 13 ADC clock cycles
+        */
+        static constexpr uint32_t getSampleRate()
+        {
+            return getSampleRate(c_prescalerCode);
+        }
+
+        /**
+        @brief Get the number of CPU cycles per conversion in free running mode
+        @result CPU cycles per conversion
+        */
+        static constexpr uint16_t getConversionCycles()
+        {
+            return static_cast<uint16_t>(getPrescaler()) * c_conversionClocks;
+        }
+
+        private:
+
+        // ADC clock cycles per conversion in free running mode
+        static constexpr uint8_t c_conversionClocks = 13;
+
+        // ADC clock division factor of a pre-scaler code. Codes 0 and 1 both select a division factor of 2
+        static constexpr uint8_t getPrescaler(const uint8_t code)
+        {
+            return static_cast<uint8_t>(1 << ((code == 0) ? 1 : code));
+        }
+
+        // Sample rate of a pre-scaler code
+        static constexpr uint32_t getSampleRate(const uint8_t code)
+        {
+            return t_cpuClock / getPrescaler(code) / c_conversionClocks;
+        }
+
+        // Check if the ADC clock of a pre-scaler code is within the range of the selected mode
+        static constexpr bool isInRange(const uint8_t code)
+        {
+            const uint32_t clock = t_cpuClock / getPrescaler(code);
+            return clock >= getMinClock() && clock <= getMaxClock();
+        }
+
+        // Fastest pre-scaler code within range, or 0 if there is none
+        static constexpr uint8_t selectFastest()
+        {
+            for (uint8_t code = 1; code <= 7; ++code)
+            {
+                if (isInRange(code))
+                {
+                    return code;
+                }
+            }
+            return 0;
+        }
+
+        // Slowest pre-scaler code within range reaching the target sample rate, or 0 if there is none
+        static constexpr uint8_t selectSlowest()
+        {
+            for (uint8_t code = 7; code >= 1; --code)
+            {
+                if (isInRange(code) && getSampleRate(code) >= t_sampleRate)
+                {
+                    return code;
+                }
+            }
+            return 0;
+        }
+
+        static_assert(selectFastest() != 0, "No ADC clock within the valid range for this CPU clock and mode!");
+
+        static constexpr uint8_t c_prescalerCode = (t_sampleRate == 0) ? selectFastest() : selectSlowest();
+        static_assert(selectFastest() == 0 || c_prescalerCode != 0, "Sample rate not reachable within the valid ADC clock range of this mode!");
+    };
+}
+
+#endif
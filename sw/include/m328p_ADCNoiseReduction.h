@@ -0,0 +1,216 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCNOISEREDUCTION_H
+#define M328P_ADCNOISEREDUCTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "register_access.h"
+#include "m328p_ADC.h"
+
+namespace m328p
+{
+    /**
+    @brief A/D conversions in ADC Noise Reduction sleep mode
+    The CPU core and the I/O clock are halted while the conversion is running, so digital noise is reduced and active current
+    is saved. Entering the sleep mode starts the conversion, and the ADC conversion complete interrupt wakes up the core.
+    All other interrupt sources which could wake up the core early are masked during the conversion and restored afterwards.
+    Interrupt flags set in the meantime are kept, so the corresponding interrupts are executed after the conversion.
+
+    Usage:
+    @code
+    m328p::ADConverter::Reader<uint16_t>::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::PrescalerSelect::DIV_128,
+    true, false, m328p::ADConverter::AutoTriggerSource::FREE_RUN, true, false, false, false, false, false);
+
+    const uint16_t value = m328p::ADCNoiseReduction::convert<uint16_t>(m328p::ADConverter::ChannelSelection::ADC0);
+
+    // The ADC interrupt handler is required to wake up the core
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+    }
+    @endcode
+
+    @note The ADC has to be initialized and must not be used by any other service (e.g. in auto trigger mode) at the same time
+    */
+    class ADCNoiseReduction
+    {
+        public:
+
+        /**
+        @brief Convert the selected channel in ADC Noise Reduction sleep mode
+        @tparam Result Type of AD conversion result (here: 8 Bit or 16 Bit unsigned)
+        @param channel Selected input channel
+        @result AD conversion result
+        @note Global interrupts are enabled during the conversion. The global interrupt flag and the result alignment are
+        restored afterwards
+        */
+        template <typename Result>
+        static Result convert(const ADConverter::ChannelSelection channel)
+        {
+            const uint8_t sreg = SREG::read();
+            cli();
+
+            // Wait for a conversion which has been started before
+            ADConverter::wait();
+
+            const WakeupSources wakeupSources = maskWakeupSources();
+            const bool autoTrigger = ADConverter::isAutoTriggerEnabled();
+            const bool interrupt = ADConverter::isInterruptEnabled();
+            const bool leftAligned = ADConverter::isLeftAligned();
+            ADConverter::enableAutoTrigger(false);
+            ADConverter::enableInterrupt(true);
+            ADConverter::selectChannel(channel);
+            ADConverter::Reader<Result>::selectAlignment();
+
+            // Entering the sleep mode starts the conversion. Interrupts are enabled with the instruction following sei, so
+            // the ADC interrupt cannot be executed before the core is asleep
+            set_sleep_mode(SLEEP_MODE_ADC);
+            sleep_enable();
+            do
+            {
+                sei();
+                sleep_cpu();
+                cli();
+            }
+            while (ADConverter::isBusy());
+            sleep_disable();
+
+            ADConverter::enableInterrupt(interrupt);
+            ADConverter::enableAutoTrigger(autoTrigger);
+            restoreWakeupSources(wakeupSources);
+
+            // The result has to be read before the alignment of other users is restored
+            const Result result = ADConverter::Reader<Result>::read();
+            if (leftAligned)
+            {
+                ADConverter::Reader<uint8_t>::selectAlignment();
+            }
+            else
+            {
+                ADConverter::Reader<uint16_t>::selectAlignment();
+            }
+
+            SREG::write(sreg);
+            return result;
+        }
+
+        private:
+
+        // Saved interrupt enable bits of all interrupt sources except the ADC
+        struct WakeupSources
+        {
+            uint8_t eimsk;
+            uint8_t pcicr;
+            uint8_t timsk0;
+            uint8_t timsk1;
+            uint8_t timsk2;
+            uint8_t ucsr0b;
+            uint8_t spcr;
+            uint8_t twcr;
+            uint8_t eecr;
+            uint8_t spmcsr;
+            uint8_t wdtcsr;
+            uint8_t acsr;
+        };
+
+        // Interrupt enable bits in registers shared with other control bits
+        static constexpr uint8_t c_ucsr0bMask = _BV(RXCIE0) | _BV(TXCIE0) | _BV(UDRIE0);
+        static constexpr uint8_t c_spcrMask = _BV(SPIE);
+        static constexpr uint8_t c_twcrMask = _BV(TWIE);
+        static constexpr uint8_t c_eecrMask = _BV(EERIE);
+        static constexpr uint8_t c_spmcsrMask = _BV(SPMIE);
+        static constexpr uint8_t c_wdtcsrMask = _BV(WDIE);
+        static constexpr uint8_t c_acsrMask = _BV(ACIE);
+
+        // Flags in these registers are cleared by writing a logical one, so they must be written as zero
+        static constexpr uint8_t c_twcrFlags = _BV(TWINT);
+        static constexpr uint8_t c_wdtcsrFlags = _BV(WDIF);
+        static constexpr uint8_t c_acsrFlags = _BV(ACI);
+
+        // Save and clear the interrupt enable bits of all interrupt sources except the ADC
+        static WakeupSources maskWakeupSources()
+        {
+            WakeupSources wakeupSources;
+
+            wakeupSources.eimsk = EIMSK::read();
+            EIMSK::write(0);
+            wakeupSources.pcicr = PCICR::read();
+            PCICR::write(0);
+            wakeupSources.timsk0 = TIMSK0::read();
+            TIMSK0::write(0);
+            wakeupSources.timsk1 = TIMSK1::read();
+            TIMSK1::write(0);
+            wakeupSources.timsk2 = TIMSK2::read();
+            TIMSK2::write(0);
+
+            wakeupSources.ucsr0b = mask<UCSR0B, c_ucsr0bMask, 0>();
+            wakeupSources.spcr = mask<SPCR, c_spcrMask, 0>();
+            wakeupSources.twcr = mask<TWCR, c_twcrMask, c_twcrFlags>();
+            wakeupSources.eecr = mask<EECR, c_eecrMask, 0>();
+            wakeupSources.spmcsr = mask<SPMCSR, c_spmcsrMask, 0>();
+            wakeupSources.wdtcsr = mask<WDTCSR, c_wdtcsrMask, c_wdtcsrFlags>();
+            wakeupSources.acsr = mask<ACSR, c_acsrMask, c_acsrFlags>();
+
+            return wakeupSources;
+        }
+
+        // Restore the interrupt enable bits saved by maskWakeupSources()
+        static void restoreWakeupSources(const WakeupSources& wakeupSources)
+        {
+            EIMSK::write(wakeupSources.eimsk);
+            PCICR::write(wakeupSources.pcicr);
+            TIMSK0::write(wakeupSources.timsk0);
+            TIMSK1::write(wakeupSources.timsk1);
+            TIMSK2::write(wakeupSources.timsk2);
+
+            restore<UCSR0B, c_ucsr0bMask, 0>(wakeupSources.ucsr0b);
+            restore<SPCR, c_spcrMask, 0>(wakeupSources.spcr);
+            restore<TWCR, c_twcrMask, c_twcrFlags>(wakeupSources.twcr);
+            restore<EECR, c_eecrMask, 0>(wakeupSources.eecr);
+            restore<SPMCSR, c_spmcsrMask, 0>(wakeupSources.spmcsr);
+            restore<WDTCSR, c_wdtcsrMask, c_wdtcsrFlags>(wakeupSources.wdtcsr);
+            restore<ACSR, c_acsrMask, c_acsrFlags>(wakeupSources.acsr);
+        }
+
+        // Clear the interrupt enable bits of a control register without clearing its flags. Returns the saved enable bits
+        template <typename Reg, uint8_t t_mask, uint8_t t_flags>
+        static uint8_t mask()
+        {
+            const uint8_t value = Reg::read();
+            if (value & t_mask)
+            {
+                Reg::write(value & ~(t_mask | t_flags));
+            }
+            return value & t_mask;
+        }
+
+        // Restore the interrupt enable bits of a control register without clearing its flags
+        template <typename Reg, uint8_t t_mask, uint8_t t_flags>
+        static void restore(const uint8_t enableBits)
+        {
+            if (enableBits != 0)
+            {
+                Reg::write((Reg::read() & ~t_flags) | enableBits);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,292 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCOVERSAMPLER_H
+#define M328P_ADCOVERSAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_ADC.h"
+#include "m328p_ADCClock.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Placeholder for ADCOversampler if no dither pin is used
+    */
+    struct ADCNoDitherPin
+    {
+        static void setAsOutput() {}
+        static void low() {}
+        static bool read() {return false;}
+        static void write(const bool) {}
+    };
+
+    /**
+    @brief Oversampling and decimation of ADC channels for an effective resolution of 11 to 16 bits
+    For t_extraBits additional bits, 4^t_extraBits conversions of a channel are accumulated in the ADC interrupt handler and the
+    sum is decimated by shifting it right by t_extraBits. The channels are processed one after another in free running mode.
+    After a channel change, one conversion is discarded, as it has already been started on the previous channel.
+    Oversampling requires noise of at least 1 LSB on the input signal. If the signal is too quiet, a dither pin can be toggled
+    on every conversion, e.g. to inject a triangular signal via an RC network.
+
+    The ADC clock is chosen at compile time by ADCClock: The lowest ADC clock within 50 kHz to 200 kHz (full 10-bit accuracy)
+    reaching the requested result rate is selected.
+
+    Usage:
+    @code
+    typedef m328p::ADCOversampler<F_CPU, 10, 4, m328p::ADCNoDitherPin,
+    m328p::ADConverter::ChannelSelection::ADC0,
+    m328p::ADConverter::ChannelSelection::ADC1> LoadCell;
+
+    int main()
+    {
+        LoadCell::init(m328p::ADConverter::ReferenceSelection::AVCC);
+        sei();
+        LoadCell::start();
+
+        while (true)
+        {
+            if (LoadCell::isUpdated(0))
+            {
+                const uint16_t value = LoadCell::read(0); // 14 bit result
+                ...
+            }
+        }
+    }
+
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+        LoadCell::handleConversionComplete();
+    }
+    @endcode
+
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam t_resultRate Minimum number of results per second and channel
+    @tparam t_extraBits Number of additional bits (1..6)
+    @tparam DitherPin GPIOPin toggled on every conversion, or ADCNoDitherPin
+    @tparam t_channels ADC input channels. The channel index is the position in this list
+    */
+    template <uint32_t t_cpuClock, uint32_t t_resultRate, uint8_t t_extraBits, typename DitherPin, ADConverter::ChannelSelection... t_channels>
+    class ADCOversampler
+    {
+        static constexpr uint8_t c_channelCount = sizeof...(t_channels);
+        static_assert(c_channelCount > 0 && c_channelCount <= 16, "ADCOversampler supports 1 to 16 channels!");
+        static_assert(t_extraBits >= 1 && t_extraBits <= 6, "ADCOversampler supports 1 to 6 additional bits!");
+        static_assert(t_resultRate != 0, "Invalid result rate!");
+
+        public:
+
+        /**
+        @brief Initialization of the ADC. Conversions are started by start()
+        @param referenceSelection Selected ADC reference voltage
+        */
+        static void init(const ADConverter::ReferenceSelection referenceSelection)
+        {
+            ADConverter::Reader<uint16_t>::init(
+            referenceSelection,
+            c_prescalerSelect,
+            true,
+            false,
+            ADConverter::AutoTriggerSource::FREE_RUN,
+            usesChannel(ADConverter::ChannelSelection::ADC0),
+            usesChannel(ADConverter::ChannelSelection::ADC1),
+            usesChannel(ADConverter::ChannelSelection::ADC2),
+            usesChannel(ADConverter::ChannelSelection::ADC3),
+            usesChannel(ADConverter::ChannelSelection::ADC4),
+            usesChannel(ADConverter::ChannelSelection::ADC5));
+
+            DitherPin::low();
+            DitherPin::setAsOutput();
+
+            for (uint8_t channelIdx = 0; channelIdx < c_channelCount; ++channelIdx)
+            {
+                s_results[channelIdx] = 0;
+            }
+            s_updated = 0;
+        }
+
+        /**
+        @brief Start conversions with the first channel
+        */
+        static void start()
+        {
+            s_channelIdx = 0;
+            s_accumulator = 0;
+            s_remaining = c_sampleCount;
+            s_discard = false;
+
+            ADConverter::selectChannel(c_channels[0]);
+            ADConverter::enableAutoTrigger(true);
+            ADConverter::startConversion();
+        }
+
+        /**
+        @brief Stop conversions. The conversion in progress is completed
+        */
+        static void stop()
+        {
+            ADConverter::enableAutoTrigger(false);
+        }
+
+        /**
+        @brief Get the effective resolution
+        @result Resolution of the results in bits
+        */
+        static constexpr uint8_t getResolution()
+        {
+            return 10 + t_extraBits;
+        }
+
+        /**
+        @brief Get the selected ADC clock pre-scaler
+        @result ADC clock pre-scaler
+        */
+        static constexpr ADConverter::PrescalerSelect getPrescalerSelect()
+        {
+            return c_prescalerSelect;
+        }
+
+        /**
+        @brief Get the achieved number of results per second and channel
+        @result Result rate in Hz (rounded down)
+        */
+        static constexpr uint32_t getResultRate()
+        {
+            return Clock::getSampleRate() / c_conversionsPerResult / c_channelCount;
+        }
+
+        /**
+        @brief Read the latest result of a channel without blocking
+        @param channelIdx Channel index
+        @result Latest result with getResolution() bits. Zero if no result is available yet
+        */
+        [[nodiscard]] static uint16_t read(const uint8_t channelIdx)
+        {
+            Atomic atomic;
+            s_updated = s_updated & ~(static_cast<uint16_t>(1) << channelIdx);
+            return s_results[channelIdx];
+        }
+
+        /**
+        @brief Check if a new result of a channel is available since its last read()
+        @param channelIdx Channel index
+        @result Flag indicating a new result is available
+        */
+        [[nodiscard]] static bool isUpdated(const uint8_t channelIdx)
+        {
+            Atomic atomic;
+            return (s_updated & (static_cast<uint16_t>(1) << channelIdx)) != 0;
+        }
+
+        /**
+        @brief ADC conversion complete handler
+        @note This method has to be called from ADConverter::handleADCInterrupt()
+        */
+        static void handleConversionComplete() __attribute__((always_inline))
+        {
+            if (s_discard)
+            {
+                // Conversion has been started on the previous channel
+                s_discard = false;
+                return;
+            }
+
+            DitherPin::write(!DitherPin::read());
+
+            const Accumulator accumulator = s_accumulator + ADConverter::Reader<uint16_t>::read();
+
+            if (--s_remaining != 0)
+            {
+                s_accumulator = accumulator;
+                return;
+            }
+
+            // Decimation
+            const uint8_t channelIdx = s_channelIdx;
+            s_results[channelIdx] = static_cast<uint16_t>(accumulator >> t_extraBits);
+            s_updated = s_updated | (static_cast<uint16_t>(1) << channelIdx);
+            s_accumulator = 0;
+            s_remaining = c_sampleCount;
+
+            if constexpr (c_channelCount > 1)
+            {
+                const uint8_t next = (channelIdx + 1 == c_channelCount) ? 0 : channelIdx + 1;
+                s_channelIdx = next;
+                ADConverter::selectChannel(c_channels[next]);
+                s_discard = true;
+            }
+        }
+
+        private:
+
+        // Number of conversions per result
+        static constexpr uint16_t c_sampleCount = static_cast<uint16_t>(1) << (2 * t_extraBits);
+
+        // Accumulator type. 16 bits hold up to 64 10-bit samples
+        template <bool t_wide, typename Dummy = void>
+        struct AccumulatorType
+        {
+            typedef uint32_t Type;
+        };
+
+        template <typename Dummy>
+        struct AccumulatorType<false, Dummy>
+        {
+            typedef uint16_t Type;
+        };
+
+        typedef typename AccumulatorType<(t_extraBits > 3)>::Type Accumulator;
+
+        // Conversions per result. One conversion is discarded per channel change
+        static constexpr uint32_t c_conversionsPerResult = c_sampleCount + ((c_channelCount > 1) ? 1 : 0);
+
+        // ADC clock up to 200 kHz reaching the required conversion rate
+        typedef ADCClock<t_cpuClock, ADCMode::PRECISE_10BIT, t_resultRate * c_conversionsPerResult * c_channelCount> Clock;
+        static constexpr ADConverter::PrescalerSelect c_prescalerSelect = Clock::getPrescalerSelect();
+
+        // ADC input channels
+        static constexpr ADConverter::ChannelSelection c_channels[c_channelCount] = {t_channels...};
+
+        // Check if a given ADC input channel is used
+        static constexpr bool usesChannel(const ADConverter::ChannelSelection channel)
+        {
+            return ((t_channels == channel) || ...);
+        }
+
+        // Latest results
+        inline static volatile uint16_t s_results[c_channelCount];
+
+        // Flags indicating a new result per channel
+        inline static volatile uint16_t s_updated = 0;
+
+        // Sum of conversions of the current channel
+        inline static Accumulator s_accumulator = 0;
+
+        // Conversions remaining for the current result
+        inline static uint16_t s_remaining = 0;
+
+        // Index of the current channel
+        inline static uint8_t s_channelIdx = 0;
+
+        // Flag indicating the next conversion has been started on the previous channel
+        inline static bool s_discard = false;
+    };
+}
+
+#endif
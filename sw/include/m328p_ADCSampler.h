@@ -0,0 +1,351 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCSAMPLER_H
+#define M328P_ADCSAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_ADC.h"
+#include "m328p_Timer0.h"
+#include "m328p_Timer1.h"
+#include "m328p_TimerFrequency.h"
+
+namespace m328p
+{
+    /**
+    @brief Fixed-rate ADC sampling pipeline. Conversions are started by a timer via the ADC auto trigger
+    The trigger timer is configured at compile time for the target sample rate, so sampling is jitter-free and does not
+    depend on interrupt latency. The ADC interrupt handler stores the results in a ring of blocks. A completed block is
+    published to the main loop without locking, and an optional callback notifies the application.
+
+    Supported trigger sources:
+    - TIMER0_COMPARE_MATCH_A: Timer0 in CTC mode with TOP = OCR0A
+    - TIMER1_COMPARE_MATCH_B: Timer1 in CTC mode with TOP = ICR1 and OCR1B = TOP
+    - TIMER1_OVERFLOW: Timer1 in fast PWM mode with TOP = ICR1
+
+    The trigger timer is used exclusively by this class. Its interrupts must not be enabled, since the ADC is only triggered
+    by a rising edge of the interrupt flag, which is cleared by handleConversionComplete().
+
+    Usage:
+    @code
+    typedef m328p::ADCSampler<F_CPU, 4000, m328p::ADConverter::AutoTriggerSource::TIMER1_COMPARE_MATCH_B, uint16_t, 64> Sampler;
+
+    int main()
+    {
+        Sampler::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::ChannelSelection::ADC0,
+        m328p::ADConverter::PrescalerSelect::DIV_128);
+        sei();
+        Sampler::start();
+
+        while (true)
+        {
+            const uint16_t* block = Sampler::getBlock();
+            if (block != nullptr)
+            {
+                // Process Sampler::getBlockSize() samples
+                ...
+                Sampler::releaseBlock();
+            }
+        }
+    }
+
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+        Sampler::handleConversionComplete();
+    }
+    @endcode
+
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam t_sampleRate Target sample rate in Hz. The ADC conversion (13.5 ADC clock cycles) has to fit into one sample period
+    @tparam t_trigger ADC auto trigger source
+    @tparam Sample Type of AD conversion result as read by ADConverter::Reader (uint8_t or uint16_t)
+    @tparam t_blockSize Number of samples per block
+    @tparam t_blockCount Number of blocks (at least 2). One block is always being filled by the interrupt handler
+    */
+    template <uint32_t t_cpuClock, uint32_t t_sampleRate, ADConverter::AutoTriggerSource t_trigger, typename Sample, uint8_t t_blockSize, uint8_t t_blockCount = 2>
+    class ADCSampler
+    {
+        static_assert(
+        t_trigger == ADConverter::AutoTriggerSource::TIMER0_COMPARE_MATCH_A ||
+        t_trigger == ADConverter::AutoTriggerSource::TIMER1_COMPARE_MATCH_B ||
+        t_trigger == ADConverter::AutoTriggerSource::TIMER1_OVERFLOW,
+        "Unsupported ADC auto trigger source!");
+        static_assert(t_blockSize > 0, "Invalid block size!");
+        static_assert(t_blockCount >= 2, "ADCSampler requires at least two blocks!");
+
+        public:
+
+        /// Notification on a completed block, called in interrupt context
+        typedef void (*Callback)(const Sample* block);
+
+        /**
+        @brief Initialization of the ADC. Sampling is started by start()
+        @param referenceSelection Selected ADC reference voltage
+        @param channel Selected input channel
+        @param prescalerSelect Selected ADC clock pre-scaler
+        @param onBlockReady Callback notifying a completed block in interrupt context. May be nullptr
+        */
+        static void init(
+        const ADConverter::ReferenceSelection referenceSelection,
+        const ADConverter::ChannelSelection channel,
+        const ADConverter::PrescalerSelect prescalerSelect,
+        const Callback onBlockReady = nullptr)
+        {
+            stop();
+
+            s_onBlockReady = onBlockReady;
+            s_writeBlock = 0;
+            s_writeIdx = 0;
+            s_readBlock = 0;
+            s_overrunCount = 0;
+
+            const uint8_t channelIdx = static_cast<uint8_t>(channel);
+            ADConverter::Reader<Sample>::init(
+            referenceSelection,
+            prescalerSelect,
+            true,
+            true,
+            t_trigger,
+            channelIdx == 0,
+            channelIdx == 1,
+            channelIdx == 2,
+            channelIdx == 3,
+            channelIdx == 4,
+            channelIdx == 5);
+
+            ADConverter::selectChannel(channel);
+        }
+
+        /**
+        @brief Start sampling. The trigger timer is started from BOTTOM
+        */
+        static void start()
+        {
+            if constexpr (t_trigger == ADConverter::AutoTriggerSource::TIMER0_COMPARE_MATCH_A)
+            {
+                typedef TimerFrequency<Timer0, t_cpuClock, t_sampleRate> Frequency;
+                Timer0::writeCounter(0);
+                Timer0::writeCompareA(Frequency::getTop());
+                Timer0::clearCompareMatchAFlag();
+                Timer0::init(
+                Timer0::WaveformGenerationMode::CTC,
+                Frequency::getClockSelect(),
+                Timer0::CompareOutputMode::DISCONNECTED,
+                Timer0::CompareOutputMode::DISCONNECTED);
+            }
+            else
+            {
+                typedef TimerFrequency<Timer1, t_cpuClock, t_sampleRate> Frequency;
+                constexpr Timer1::WaveformGenerationMode waveformGenerationMode =
+                (t_trigger == ADConverter::AutoTriggerSource::TIMER1_OVERFLOW) ?
+                Timer1::WaveformGenerationMode::PWM_FAST_1 :
+                Timer1::WaveformGenerationMode::CTC_2;
+
+                // ICR1 can only be written if it is used as TOP
+                Timer1::init(
+                waveformGenerationMode,
+                Timer1::ClockSelect::NONE,
+                Timer1::CompareOutputMode::DISCONNECTED,
+                Timer1::CompareOutputMode::DISCONNECTED);
+
+                Timer1::writeCounter<Timer1::Access::GUARDED>(0);
+                Timer1::writeInputCapture<Timer1::Access::GUARDED>(Frequency::getTop());
+                Timer1::writeCompareB<Timer1::Access::GUARDED>(Frequency::getTop());
+                clearTriggerFlag();
+
+                Timer1::init(
+                waveformGenerationMode,
+                Frequency::getClockSelect(),
+                Timer1::CompareOutputMode::DISCONNECTED,
+                Timer1::CompareOutputMode::DISCONNECTED);
+            }
+        }
+
+        /**
+        @brief Stop sampling. The trigger timer is stopped, a conversion in progress is completed
+        */
+        static void stop()
+        {
+            if constexpr (t_trigger == ADConverter::AutoTriggerSource::TIMER0_COMPARE_MATCH_A)
+            {
+                Timer0::init(
+                Timer0::WaveformGenerationMode::CTC,
+                Timer0::ClockSelect::NONE,
+                Timer0::CompareOutputMode::DISCONNECTED,
+                Timer0::CompareOutputMode::DISCONNECTED);
+            }
+            else
+            {
+                Timer1::init(
+                Timer1::WaveformGenerationMode::NORMAL,
+                Timer1::ClockSelect::NONE,
+                Timer1::CompareOutputMode::DISCONNECTED,
+                Timer1::CompareOutputMode::DISCONNECTED);
+            }
+        }
+
+        /**
+        @brief Get the achieved sample rate
+        @result Sample rate in Hz (rounded)
+        */
+        static constexpr uint32_t getSampleRate()
+        {
+            if constexpr (t_trigger == ADConverter::AutoTriggerSource::TIMER0_COMPARE_MATCH_A)
+            {
+                return TimerFrequency<Timer0, t_cpuClock, t_sampleRate>::getFrequency();
+            }
+            else
+            {
+                return TimerFrequency<Timer1, t_cpuClock, t_sampleRate>::getFrequency();
+            }
+        }
+
+        /**
+        @brief Get the number of samples per block
+        @result Block size
+        */
+        static constexpr uint8_t getBlockSize()
+        {
+            return t_blockSize;
+        }
+
+        /**
+        @brief Check if a completed block is available
+        @result Flag indicating getBlock() will return a block
+        */
+        [[nodiscard]] static bool isBlockReady()
+        {
+            return s_readBlock != s_writeBlock;
+        }
+
+        /**
+        @brief Get the oldest completed block. The block remains valid until releaseBlock() is called
+        @result Pointer to getBlockSize() samples, or nullptr if no block is available
+        */
+        [[nodiscard]] static const Sample* getBlock()
+        {
+            const uint8_t readBlock = s_readBlock;
+            return (readBlock != s_writeBlock) ? s_blocks[readBlock] : nullptr;
+        }
+
+        /**
+        @brief Return the block obtained by getBlock() to the interrupt handler
+        */
+        static void releaseBlock()
+        {
+            const uint8_t readBlock = s_readBlock;
+            if (readBlock != s_writeBlock)
+            {
+                s_readBlock = next(readBlock);
+            }
+        }
+
+        /**
+        @brief Get the number of blocks discarded because no free block was available
+        @result Number of discarded blocks (saturating)
+        */
+        [[nodiscard]] static uint8_t getOverrunCount()
+        {
+            return s_overrunCount;
+        }
+
+        /**
+        @brief ADC conversion complete handler
+        @note This method has to be called from ADConverter::handleADCInterrupt()
+        */
+        static void handleConversionComplete() __attribute__((always_inline))
+        {
+            // Re-arm the auto trigger
+            clearTriggerFlag();
+
+            const uint8_t writeBlock = s_writeBlock;
+            uint8_t writeIdx = s_writeIdx;
+            s_blocks[writeBlock][writeIdx] = ADConverter::Reader<Sample>::read();
+
+            if (++writeIdx == t_blockSize)
+            {
+                writeIdx = 0;
+
+                const uint8_t nextBlock = next(writeBlock);
+                if (nextBlock != s_readBlock)
+                {
+                    // Make sure the block is written completely before it is published
+                    __asm__ __volatile__ ("" ::: "memory");
+                    s_writeBlock = nextBlock;
+
+                    if (s_onBlockReady != nullptr)
+                    {
+                        s_onBlockReady(s_blocks[writeBlock]);
+                    }
+                }
+                else if (s_overrunCount != UINT8_MAX)
+                {
+                    // No free block. The current block is overwritten
+                    s_overrunCount = s_overrunCount + 1;
+                }
+            }
+
+            s_writeIdx = writeIdx;
+        }
+
+        private:
+
+        // Clear the interrupt flag of the trigger source. The ADC is triggered by its rising edge only
+        static void clearTriggerFlag() __attribute__((always_inline))
+        {
+            if constexpr (t_trigger == ADConverter::AutoTriggerSource::TIMER0_COMPARE_MATCH_A)
+            {
+                Timer0::clearCompareMatchAFlag();
+            }
+            else if constexpr (t_trigger == ADConverter::AutoTriggerSource::TIMER1_COMPARE_MATCH_B)
+            {
+                Timer1::clearCompareMatchBFlag();
+            }
+            else
+            {
+                Timer1::clearOverflowFlag();
+            }
+        }
+
+        // Next block index
+        static uint8_t next(const uint8_t blockIdx) __attribute__((always_inline))
+        {
+            return (blockIdx + 1 == t_blockCount) ? 0 : blockIdx + 1;
+        }
+
+        // Sample blocks
+        inline static Sample s_blocks[t_blockCount][t_blockSize];
+
+        // Block being filled by the interrupt handler. Blocks from s_readBlock up to s_writeBlock (exclusive) are completed
+        inline static volatile uint8_t s_writeBlock = 0;
+
+        // Index of the next sample in the block being filled
+        inline static uint8_t s_writeIdx = 0;
+
+        // Oldest completed block
+        inline static volatile uint8_t s_readBlock = 0;
+
+        // Number of discarded blocks
+        inline static volatile uint8_t s_overrunCount = 0;
+
+        // Block ready notification
+        inline static Callback s_onBlockReady = nullptr;
+    };
+}
+
+#endif
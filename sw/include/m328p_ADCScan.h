@@ -0,0 +1,255 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCSCAN_H
+#define M328P_ADCSCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_ADC.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Channel of an ADC scan sequence
+    @tparam t_channel ADC input channel
+    @tparam t_divisor Sample rate divisor. The channel is converted in every t_divisor-th round of the scan sequence
+    */
+    template <ADConverter::ChannelSelection t_channel, uint8_t t_divisor = 1>
+    struct ADCScanChannel
+    {
+        static_assert(t_divisor != 0, "Invalid sample rate divisor!");
+
+        /// ADC input channel
+        static constexpr ADConverter::ChannelSelection c_channel = t_channel;
+
+        /// Sample rate divisor
+        static constexpr uint8_t c_divisor = t_divisor;
+    };
+
+    /**
+    @brief Interrupt-driven scan sequencer converting a compile-time list of ADC channels in free running mode
+    The ADC interrupt handler stores each result in a table of latest values and selects the next channel due in the scan
+    sequence. In free running mode, the next conversion is already running when the interrupt handler is executed, so a new
+    MUX setting only takes effect for the conversion after next. The sequencer keeps track of this pipeline, so every result
+    is assigned to the channel it has actually been converted from.
+
+    Usage:
+    @code
+    typedef m328p::ADCScan<uint16_t,
+    m328p::ADCScanChannel<m328p::ADConverter::ChannelSelection::ADC0>,
+    m328p::ADCScanChannel<m328p::ADConverter::ChannelSelection::ADC1>,
+    m328p::ADCScanChannel<m328p::ADConverter::ChannelSelection::ADC2, 10>> Scan;
+
+    int main()
+    {
+        Scan::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::PrescalerSelect::DIV_128);
+        sei();
+        Scan::start();
+
+        while (true)
+        {
+            const uint16_t value = Scan::read(Scan::indexOf<m328p::ADConverter::ChannelSelection::ADC1>());
+            ...
+        }
+    }
+
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+        Scan::handleConversionComplete();
+    }
+    @endcode
+
+    @tparam Sample Type of AD conversion result as read by ADConverter::Reader (uint8_t or uint16_t)
+    @tparam Channels ADCScanChannel types. The channel index is the position in this list
+    @note At least one channel must have a divisor of one. This bounds the execution time of the interrupt handler
+    */
+    template <typename Sample, typename... Channels>
+    class ADCScan
+    {
+        static constexpr uint8_t c_channelCount = sizeof...(Channels);
+        static_assert(c_channelCount > 0 && c_channelCount <= 16, "ADCScan supports 1 to 16 channels!");
+        static_assert(((Channels::c_divisor == 1) || ...), "At least one channel must have a sample rate divisor of one!");
+
+        public:
+
+        /**
+        @brief Initialization of the ADC. Scanning is started by start()
+        @param referenceSelection Selected ADC reference voltage
+        @param prescalerSelect Selected ADC clock pre-scaler
+        */
+        static void init(const ADConverter::ReferenceSelection referenceSelection, const ADConverter::PrescalerSelect prescalerSelect)
+        {
+            ADConverter::Reader<Sample>::init(
+            referenceSelection,
+            prescalerSelect,
+            true,
+            false,
+            ADConverter::AutoTriggerSource::FREE_RUN,
+            usesChannel(ADConverter::ChannelSelection::ADC0),
+            usesChannel(ADConverter::ChannelSelection::ADC1),
+            usesChannel(ADConverter::ChannelSelection::ADC2),
+            usesChannel(ADConverter::ChannelSelection::ADC3),
+            usesChannel(ADConverter::ChannelSelection::ADC4),
+            usesChannel(ADConverter::ChannelSelection::ADC5));
+
+            for (uint8_t channelIdx = 0; channelIdx < c_channelCount; ++channelIdx)
+            {
+                s_values[channelIdx] = 0;
+                s_countdowns[channelIdx] = 1;
+            }
+            s_updated = 0;
+        }
+
+        /**
+        @brief Start scanning with the first channel
+        */
+        static void start()
+        {
+            // The first two conversions both use the first channel, as the MUX setting for the second conversion cannot be
+            // changed safely before the first conversion has started
+            s_converting = 0;
+            s_selected = 0;
+            ADConverter::selectChannel(c_channels[0]);
+            ADConverter::enableAutoTrigger(true);
+            ADConverter::startConversion();
+        }
+
+        /**
+        @brief Stop scanning. The conversion in progress is completed and stored
+        */
+        static void stop()
+        {
+            ADConverter::enableAutoTrigger(false);
+        }
+
+        /**
+        @brief Get the number of channels
+        @result Number of channels
+        */
+        static constexpr uint8_t getChannelCount()
+        {
+            return c_channelCount;
+        }
+
+        /**
+        @brief Get the index of an ADC input channel in the scan sequence
+        @tparam t_channel ADC input channel
+        @result Channel index
+        */
+        template <ADConverter::ChannelSelection t_channel>
+        static constexpr uint8_t indexOf()
+        {
+            static_assert(usesChannel(t_channel), "Channel is not part of the scan sequence!");
+            uint8_t channelIdx = 0;
+            while (c_channels[channelIdx] != t_channel)
+            {
+                ++channelIdx;
+            }
+            return channelIdx;
+        }
+
+        /**
+        @brief Read the latest conversion result of a channel without blocking
+        @param channelIdx Channel index
+        @result Latest conversion result. Zero if the channel has not been converted yet
+        */
+        [[nodiscard]] static Sample read(const uint8_t channelIdx)
+        {
+            Atomic atomic;
+            s_updated = s_updated & ~(static_cast<uint16_t>(1) << channelIdx);
+            return s_values[channelIdx];
+        }
+
+        /**
+        @brief Check if a channel has been converted since its last read()
+        @param channelIdx Channel index
+        @result Flag indicating a new conversion result is available
+        */
+        [[nodiscard]] static bool isUpdated(const uint8_t channelIdx)
+        {
+            Atomic atomic;
+            return (s_updated & (static_cast<uint16_t>(1) << channelIdx)) != 0;
+        }
+
+        /**
+        @brief ADC conversion complete handler
+        @result Index of the channel the completed conversion belongs to, e.g. for ADCWindowMonitor::evaluate()
+        @note This method has to be called from ADConverter::handleADCInterrupt()
+        */
+        static uint8_t handleConversionComplete() __attribute__((always_inline))
+        {
+            // The completed conversion belongs to the channel converted before, while the channel selected before is being
+            // converted now
+            const uint8_t completed = s_converting;
+            const uint8_t selected = s_selected;
+            s_values[completed] = ADConverter::Reader<Sample>::read();
+            s_updated = s_updated | (static_cast<uint16_t>(1) << completed);
+            s_converting = selected;
+
+            // Select the next channel due. Each channel is visited once per round and converted in every divisor-th round
+            uint8_t next = selected;
+            while (true)
+            {
+                if (++next == c_channelCount)
+                {
+                    next = 0;
+                }
+
+                if (--s_countdowns[next] == 0)
+                {
+                    s_countdowns[next] = c_divisors[next];
+                    break;
+                }
+            }
+
+            s_selected = next;
+            ADConverter::selectChannel(c_channels[next]);
+            return completed;
+        }
+
+        private:
+
+        // ADC input channels and divisors in scan order
+        static constexpr ADConverter::ChannelSelection c_channels[c_channelCount] = {Channels::c_channel...};
+        static constexpr uint8_t c_divisors[c_channelCount] = {Channels::c_divisor...};
+
+        // Check if a given ADC input channel is part of the scan sequence
+        static constexpr bool usesChannel(const ADConverter::ChannelSelection channel)
+        {
+            return ((Channels::c_channel == channel) || ...);
+        }
+
+        // Latest conversion results
+        inline static volatile Sample s_values[c_channelCount];
+
+        // Flags indicating a new conversion result per channel
+        inline static volatile uint16_t s_updated = 0;
+
+        // Rounds until the next conversion per channel
+        inline static uint8_t s_countdowns[c_channelCount];
+
+        // Channel index of the conversion in progress
+        inline static uint8_t s_converting = 0;
+
+        // Channel index selected for the next conversion
+        inline static uint8_t s_selected = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,245 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ADCWINDOWMONITOR_H
+#define M328P_ADCWINDOWMONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Atomic.h"
+#include "m328p_RingBuffer.h"
+
+namespace m328p
+{
+    /**
+    @brief Window comparator for ADC channels, evaluated in the ADC interrupt handler
+    Each channel has a window defined by a low and a high threshold. Every conversion result is classified as below, inside
+    or above the window, and an event is queued only if the zone changes. To avoid chattering, a result has to be inside
+    the window by at least the hysteresis to return into the window.
+
+    Usage:
+    @code
+    typedef m328p::ADCScan<uint16_t,
+    m328p::ADCScanChannel<m328p::ADConverter::ChannelSelection::ADC0>,
+    m328p::ADCScanChannel<m328p::ADConverter::ChannelSelection::ADC1>> Scan;
+    typedef m328p::ADCWindowMonitor<uint16_t, Scan::getChannelCount()> Monitor;
+
+    int main()
+    {
+        Scan::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::PrescalerSelect::DIV_128);
+        Monitor::setWindow(0, {100, 900, 10});
+        Monitor::setWindow(1, {0, 512, 4});
+        sei();
+        Scan::start();
+
+        while (true)
+        {
+            Monitor::Event event;
+            while (Monitor::getEvent(event))
+            {
+                if (event.zone == Monitor::Zone::ABOVE)
+                {
+                    ...
+                }
+            }
+
+            // Sleep until the next interrupt
+            ...
+        }
+    }
+
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+        const uint8_t channelIdx = Scan::handleConversionComplete();
+        Monitor::evaluate(channelIdx, m328p::ADConverter::Reader<uint16_t>::read());
+    }
+    @endcode
+
+    @tparam Sample Type of AD conversion result
+    @tparam t_channelCount Number of monitored channels
+    @tparam t_queueSize Size of the event queue (power of two). One entry is kept free
+    */
+    template <typename Sample, uint8_t t_channelCount, uint8_t t_queueSize = 8>
+    class ADCWindowMonitor
+    {
+        static_assert(t_channelCount > 0 && t_channelCount <= 16, "ADCWindowMonitor supports 1 to 16 channels!");
+
+        public:
+
+        ///@brief Position of a conversion result relative to the window
+        enum class Zone : uint8_t
+        {
+            UNKNOWN, // No conversion result evaluated yet
+            BELOW,
+            INSIDE,
+            ABOVE
+        };
+
+        ///@brief Window of a channel
+        struct Window
+        {
+            Sample low; // Results below this threshold are below the window
+            Sample high; // Results above this threshold are above the window
+            Sample hysteresis; // Distance from a threshold required to return into the window
+        };
+
+        ///@brief Zone change of a channel
+        struct Event
+        {
+            uint8_t channelIdx;
+            Zone zone; // New zone
+        };
+
+        /**
+        @brief Set the window of a channel and enable its monitoring. The channel is re-evaluated with its next conversion result
+        @param channelIdx Channel index
+        @param window Window
+        */
+        static void setWindow(const uint8_t channelIdx, const Window& window)
+        {
+            Atomic atomic;
+            s_windows[channelIdx] = window;
+            s_zones[channelIdx] = Zone::UNKNOWN;
+            s_enabled = s_enabled | (static_cast<uint16_t>(1) << channelIdx);
+        }
+
+        /**
+        @brief Disable the monitoring of a channel
+        @param channelIdx Channel index
+        */
+        static void disableWindow(const uint8_t channelIdx)
+        {
+            Atomic atomic;
+            s_enabled = s_enabled & ~(static_cast<uint16_t>(1) << channelIdx);
+            s_zones[channelIdx] = Zone::UNKNOWN;
+        }
+
+        /**
+        @brief Get the current zone of a channel
+        @param channelIdx Channel index
+        @result Zone of the latest conversion result
+        */
+        [[nodiscard]] static Zone getZone(const uint8_t channelIdx)
+        {
+            return s_zones[channelIdx];
+        }
+
+        /**
+        @brief Remove the oldest event from the queue
+        @param event Removed event
+        @result Flag indicating an event has been removed. False if no event is pending
+        */
+        static bool getEvent(Event& event)
+        {
+            return s_events.pop(event);
+        }
+
+        /**
+        @brief Check if an event is pending
+        @result Flag indicating an event is pending
+        */
+        [[nodiscard]] static bool hasEvent()
+        {
+            return !s_events.isEmpty();
+        }
+
+        /**
+        @brief Get the number of events lost because the queue was full
+        @result Number of lost events (saturating)
+        */
+        [[nodiscard]] static uint8_t getLostEventCount()
+        {
+            return s_lostEventCount;
+        }
+
+        /**
+        @brief Evaluate a conversion result. An event is queued if the zone of the channel changes
+        The first result after setWindow() only queues an event if it is outside the window. Results of channels without a
+        window are ignored
+        @param channelIdx Channel index
+        @param value Conversion result
+        @note This method has to be called from ADConverter::handleADCInterrupt()
+        */
+        static void evaluate(const uint8_t channelIdx, const Sample value) __attribute__((always_inline))
+        {
+            if ((s_enabled & (static_cast<uint16_t>(1) << channelIdx)) == 0)
+            {
+                return;
+            }
+
+            const Window& window = s_windows[channelIdx];
+            const Zone zone = s_zones[channelIdx];
+
+            Zone next;
+            if (value > window.high)
+            {
+                next = Zone::ABOVE;
+            }
+            else if (value < window.low)
+            {
+                next = Zone::BELOW;
+            }
+            else if (zone == Zone::ABOVE && value > window.high - window.hysteresis)
+            {
+                next = Zone::ABOVE;
+            }
+            else if (zone == Zone::BELOW && value < window.low + window.hysteresis)
+            {
+                next = Zone::BELOW;
+            }
+            else
+            {
+                next = Zone::INSIDE;
+            }
+
+            if (next == zone)
+            {
+                return;
+            }
+
+            s_zones[channelIdx] = next;
+            if (zone == Zone::UNKNOWN && next == Zone::INSIDE)
+            {
+                return;
+            }
+
+            if (!s_events.push(Event{channelIdx, next}) && s_lostEventCount != UINT8_MAX)
+            {
+                s_lostEventCount = s_lostEventCount + 1;
+            }
+        }
+
+        private:
+
+        // Windows per channel
+        inline static Window s_windows[t_channelCount] = {};
+
+        // Flags indicating a window is set per channel
+        inline static uint16_t s_enabled = 0;
+
+        // Current zone per channel
+        inline static volatile Zone s_zones[t_channelCount] = {};
+
+        // Pending events
+        inline static RingBuffer<Event, t_queueSize> s_events;
+
+        // Number of lost events
+        inline static volatile uint8_t s_lostEventCount = 0;
+    };
+}
+
+#endif
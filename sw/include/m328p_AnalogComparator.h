@@ -0,0 +1,268 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_ANALOGCOMPARATOR_H
+#define M328P_ANALOGCOMPARATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/interrupt.h>
+#include "register_access.h"
+#include "m328p_GPIO.h"
+#include "m328p_ADC.h"
+
+namespace m328p
+{
+    /**
+    @brief Register-level driver for the analog comparator on ATMega328P
+    The comparator output is set if the positive input (AIN0 or the internal bandgap reference) is higher than the negative
+    input (AIN1 or one of the ADC input channels ADC0..ADC7). The ADC channels are multiplexed via ADMUX, so the ADC is
+    disabled while one of them is selected as negative input.
+
+    Edges of the comparator output can trigger the analog comparator interrupt. Alternatively, the comparator output can be
+    routed to the input capture unit of Timer1, so threshold crossings are timestamped by hardware. In this case, the trigger
+    edge, the noise canceler and the interrupt are configured by Timer1.
+
+    Usage:
+    @code
+    // Timestamp rising zero crossings of a signal at AIN0 against a reference at ADC3
+    m328p::AnalogComparator::init(
+    m328p::AnalogComparator::PositiveInput::AIN0,
+    m328p::AnalogComparator::NegativeInput::ADC3,
+    m328p::AnalogComparator::InterruptMode::TOGGLE,
+    false,
+    true);
+
+    m328p::Timer1::setInputCaptureEdge(m328p::Timer1::InputCaptureEdge::RISING);
+    m328p::Timer1::clearInputCaptureFlag();
+    m328p::Timer1::enableInputCaptureInterrupt();
+
+    void m328p::Timer1::handleCAPT()
+    {
+        const uint16_t timestamp = m328p::Timer1::readInputCapture();
+        ...
+    }
+    @endcode
+    */
+    class AnalogComparator
+    {
+        public:
+
+        ///@brief Positive comparator input
+        enum class PositiveInput : uint8_t
+        {
+            AIN0 = 0, // Pin PD6
+            BANDGAP = 1 // Internal bandgap reference (1.1V)
+        };
+
+        ///@brief Negative comparator input
+        enum class NegativeInput : uint8_t
+        {
+            ADC0 = 0b0000,
+            ADC1 = 0b0001,
+            ADC2 = 0b0010,
+            ADC3 = 0b0011,
+            ADC4 = 0b0100,
+            ADC5 = 0b0101,
+            ADC6 = 0b0110,
+            ADC7 = 0b0111,
+            AIN1 = 0b1000 // Pin PD7
+        };
+
+        ///@brief Analog Comparator Interrupt Mode Select
+        enum class InterruptMode : uint8_t
+        {
+            TOGGLE = 0b00,
+            FALLING = 0b10,
+            RISING = 0b11
+        };
+
+        /**
+        @brief Initialization. The comparator is enabled
+        @param positiveInput Selected positive input
+        @param negativeInput Selected negative input
+        @param interruptMode Edge of the comparator output setting the interrupt flag
+        @param interruptEnable Flag indicating the analog comparator interrupt is enabled
+        @param inputCaptureEnable Flag indicating the comparator output triggers the Timer1 input capture
+        */
+        static void init(
+        const PositiveInput positiveInput,
+        const NegativeInput negativeInput,
+        const InterruptMode interruptMode = InterruptMode::TOGGLE,
+        const bool interruptEnable = true,
+        const bool inputCaptureEnable = false)
+        {
+            // The interrupt has to be disabled while the comparator configuration is changed
+            disableInterrupt();
+
+            if (positiveInput == PositiveInput::AIN0)
+            {
+                AIN0_Pin::setAsInput();
+                AIN0D_bit::set();
+            }
+            selectNegativeInput(negativeInput);
+
+            modify(
+            _BV(ACD) | _BV(ACBG) | _BV(ACIC) | _BV(ACIS1) | _BV(ACIS0),
+            (positiveInput == PositiveInput::BANDGAP ? _BV(ACBG) : 0) |
+            (inputCaptureEnable ? _BV(ACIC) : 0) |
+            (static_cast<uint8_t>(interruptMode) << ACIS0));
+
+            clearInterruptFlag();
+            if (interruptEnable)
+            {
+                enableInterrupt();
+            }
+        }
+
+        /**
+        @brief Select the negative input
+        @param negativeInput Selected negative input
+        @note If an ADC input channel is selected, the ADC is disabled and the ADC channel selection is overwritten. The ADC has
+        to be enabled by the user again after selecting AIN1
+        */
+        static void selectNegativeInput(const NegativeInput negativeInput)
+        {
+            if (negativeInput == NegativeInput::AIN1)
+            {
+                AIN1_Pin::setAsInput();
+                AIN1D_bit::set();
+                ACME_bit::clear();
+            }
+            else
+            {
+                ADConverter::enable(false);
+                ADConverter::selectChannel(static_cast<ADConverter::ChannelSelection>(negativeInput));
+                ACME_bit::set();
+            }
+        }
+
+        /**
+        @brief Select the edge of the comparator output setting the interrupt flag
+        @param interruptMode Selected edge
+        @note The interrupt is disabled during the change and a pending interrupt is cleared
+        */
+        static void setInterruptMode(const InterruptMode interruptMode)
+        {
+            const uint8_t interruptEnable = ACSR::read() & _BV(ACIE);
+            disableInterrupt();
+            modify(_BV(ACIS1) | _BV(ACIS0), static_cast<uint8_t>(interruptMode) << ACIS0);
+            clearInterruptFlag();
+            modify(0, interruptEnable);
+        }
+
+        /**
+        @brief Enable the comparator
+        */
+        static void enable() __attribute__((always_inline))
+        {
+            modify(_BV(ACD), 0);
+        }
+
+        /**
+        @brief Disable the comparator to save power. The interrupt is disabled as well
+        */
+        static void disable() __attribute__((always_inline))
+        {
+            // The interrupt has to be disabled before the comparator is switched off
+            modify(_BV(ACIE), 0);
+            modify(0, _BV(ACD));
+        }
+
+        /**
+        @brief Read the comparator output
+        @result Flag indicating the positive input is higher than the negative input
+        */
+        [[nodiscard]] static bool read() __attribute__((always_inline))
+        {
+            return (ACSR::read() & _BV(ACO)) != 0;
+        }
+
+        /**
+        @brief Enable Interrupt
+        */
+        static void enableInterrupt() __attribute__((always_inline))
+        {
+            // Set interrupt enable flag
+            modify(0, _BV(ACIE));
+        }
+
+        /**
+        @brief Disable Interrupt
+        */
+        static void disableInterrupt() __attribute__((always_inline))
+        {
+            // Clear interrupt enable flag
+            modify(_BV(ACIE), 0);
+        }
+
+        /**
+        @brief Clear a pending analog comparator interrupt
+        */
+        static void clearInterruptFlag() __attribute__((always_inline))
+        {
+            // The interrupt flag is cleared by writing a logical one
+            ACSR::write(ACSR::read() | _BV(ACI));
+        }
+
+        /**
+        @brief Check if an analog comparator interrupt is pending
+        @result Flag indicating the selected edge has occurred
+        */
+        [[nodiscard]] static bool isInterruptPending() __attribute__((always_inline))
+        {
+            return (ACSR::read() & _BV(ACI)) != 0;
+        }
+
+        /**
+        @brief Enable or disable the routing of the comparator output to the Timer1 input capture unit
+        @param enable Flag indicating the comparator output triggers the Timer1 input capture instead of ICP1
+        @note Changing the trigger source may trigger a capture. Clear the Timer1 input capture flag afterwards, if required
+        */
+        static void enableInputCapture(const bool enable) __attribute__((always_inline))
+        {
+            modify(_BV(ACIC), enable ? _BV(ACIC) : 0);
+        }
+
+        private:
+
+        // Modify the control bits in ACSR. The interrupt flag is written as zero, so a pending interrupt is not cleared
+        static void modify(const uint8_t clearMask, const uint8_t setMask) __attribute__((always_inline))
+        {
+            ACSR::write((ACSR::read() & ~(clearMask | _BV(ACI))) | setMask);
+        }
+
+        // Analog Comparator Multiplexer Enable
+        typedef BitInRegister<ADCSRB, ACME> ACME_bit;
+
+        // Digital Input Disable Register 1
+        typedef BitInRegister<DIDR1, AIN0D> AIN0D_bit;
+        typedef BitInRegister<DIDR1, AIN1D> AIN1D_bit;
+
+        // AIN0 Pin PD6, AIN1 Pin PD7
+        typedef GPIOPin<Port::D, 6> AIN0_Pin;
+        typedef GPIOPin<Port::D, 7> AIN1_Pin;
+
+        /**
+        @brief Analog comparator interrupt handler
+        @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
+        */
+        static void handleInterrupt() __asm__("__vector_23") __attribute__((__signal__, __used__, __externally_visible__));
+    };
+}
+
+#endif
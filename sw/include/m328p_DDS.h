@@ -0,0 +1,247 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_DDS_H
+#define M328P_DDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "m328p_Timer2.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Direct digital synthesis (DDS) waveform generator on both output compare channels of an 8-bit timer
+    The timer runs in fast PWM mode at full CPU clock with TOP = 0xFF, so the sample rate is F_CPU / 256 (62.5 kHz at 16 MHz).
+    For each channel, the overflow interrupt advances a 32-bit phase accumulator by the tuning word and writes the wavetable
+    entry addressed by the upper 8 bits of the phase to the compare register, which is applied by hardware at the next BOTTOM.
+    A frequency change only replaces the tuning word, so the phase is continuous and the waveform has no glitches.
+    The interrupt handler takes well below 100 cycles of the 256 cycle sample period. An RC low pass on the output pins is
+    required to remove the PWM carrier.
+
+    Usage:
+    @code
+    typedef m328p::DDS<F_CPU> Tone;
+
+    int main()
+    {
+        Tone::init();
+        sei();
+        Tone::setFrequency(Tone::Channel::A, 440);
+        Tone::setFrequency(Tone::Channel::B, 880);
+        ...
+    }
+
+    void m328p::Timer2::handleOVF()
+    {
+        Tone::handleOverflow();
+    }
+    @endcode
+
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam Timer Timer driver class (Timer2 or Timer0)
+    @note The overflow interrupt is used exclusively by this class
+    */
+    template <uint32_t t_cpuClock, typename Timer = Timer2>
+    class DDS
+    {
+        public:
+
+        ///@brief Output channel
+        enum class Channel : uint8_t
+        {
+            A = 0, // OCxA pin
+            B = 1 // OCxB pin
+        };
+
+        /// Sine wavetable in program memory (256 entries, offset 128, amplitude 127)
+        inline static const uint8_t c_sine[256] PROGMEM =
+        {
+            128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
+            177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216,
+            218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244,
+            245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+            255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+            245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+            218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179,
+            177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131,
+            128, 125, 122, 119, 116, 112, 109, 106, 103, 100,  97,  94,  91,  88,  85,  82,
+             79,  77,  74,  71,  68,  65,  63,  60,  57,  55,  52,  50,  47,  45,  43,  40,
+             38,  36,  34,  32,  30,  28,  26,  24,  22,  21,  19,  17,  16,  15,  13,  12,
+             11,  10,   8,   7,   6,   6,   5,   4,   3,   3,   2,   2,   2,   1,   1,   1,
+              1,   1,   1,   1,   2,   2,   2,   3,   3,   4,   5,   6,   6,   7,   8,  10,
+             11,  12,  13,  15,  16,  17,  19,  21,  22,  24,  26,  28,  30,  32,  34,  36,
+             38,  40,  43,  45,  47,  50,  52,  55,  57,  60,  63,  65,  68,  71,  74,  77,
+             79,  82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125,
+        };
+
+        /**
+        @brief Initialization. Both outputs are enabled with the sine wavetable and frequency 0, i.e. at mid-scale
+        */
+        static void init()
+        {
+            for (uint8_t channelIdx = 0; channelIdx < 2; ++channelIdx)
+            {
+                s_wavetables[channelIdx] = c_sine;
+                s_phases[channelIdx] = 0;
+                s_tuningWords[channelIdx] = 0;
+            }
+
+            Timer::writeCompareA(pgm_read_byte(c_sine));
+            Timer::writeCompareB(pgm_read_byte(c_sine));
+            Timer::OCA_Pin::setAsOutput();
+            Timer::OCB_Pin::setAsOutput();
+
+            Timer::init(
+            Timer::WaveformGenerationMode::PWM_FAST_1,
+            Timer::ClockSelect::PRESCALER_1,
+            Timer::CompareOutputMode::CLEAR,
+            Timer::CompareOutputMode::CLEAR);
+
+            Timer::clearOverflowFlag();
+            Timer::enableOverflowInterrupt();
+        }
+
+        /**
+        @brief Get the sample rate
+        @result Sample rate in Hz
+        */
+        static constexpr uint32_t getSampleRate()
+        {
+            return t_cpuClock / 256;
+        }
+
+        /**
+        @brief Get the highest frequency which can be generated (Nyquist frequency)
+        @result Maximum frequency in Hz
+        */
+        static constexpr uint16_t getMaximumFrequency()
+        {
+            return getSampleRate() / 2;
+        }
+
+        /**
+        @brief Convert a frequency to a tuning word. Evaluated without division, so it is cheap at runtime, too
+        @param frequency Frequency in Hz (0..getMaximumFrequency())
+        @result Tuning word, i.e. phase increment per sample
+        */
+        static constexpr uint32_t toTuningWord(const uint16_t frequency)
+        {
+            return frequency * c_tuningWordPerHz + ((static_cast<uint32_t>(frequency) * c_tuningWordPerHzFraction) >> 16);
+        }
+
+        /**
+        @brief Set the output frequency of a channel
+        @param channel Output channel
+        @param frequency Frequency in Hz (0..getMaximumFrequency())
+        */
+        static void setFrequency(const Channel channel, const uint16_t frequency)
+        {
+            setTuningWord(channel, toTuningWord(frequency));
+        }
+
+        /**
+        @brief Set the tuning word of a channel. The phase is continued, so the frequency changes without a glitch
+        @param channel Output channel
+        @param tuningWord Phase increment per sample. The output frequency is tuningWord * getSampleRate() / 2^32
+        */
+        static void setTuningWord(const Channel channel, const uint32_t tuningWord)
+        {
+            Atomic atomic;
+            s_tuningWords[static_cast<uint8_t>(channel)] = tuningWord;
+        }
+
+        /**
+        @brief Set the phase of a channel, e.g. to establish a defined phase relation between both channels
+        @param channel Output channel
+        @param phase Phase (full circle = 2^32)
+        */
+        static void setPhase(const Channel channel, const uint32_t phase)
+        {
+            Atomic atomic;
+            s_phases[static_cast<uint8_t>(channel)] = phase;
+        }
+
+        /**
+        @brief Select the wavetable of a channel. The change takes effect with the next sample
+        @param channel Output channel
+        @param wavetable Wavetable of 256 samples in program memory
+        */
+        static void setWavetable(const Channel channel, const uint8_t* const wavetable)
+        {
+            Atomic atomic;
+            s_wavetables[static_cast<uint8_t>(channel)] = wavetable;
+        }
+
+        /**
+        @brief Enable or disable the output of a channel. A disabled output pin is driven low
+        @param channel Output channel
+        @param enable Flag indicating the output is enabled
+        */
+        static void enableOutput(const Channel channel, const bool enable)
+        {
+            const typename Timer::CompareOutputMode compareOutputMode =
+            enable ? Timer::CompareOutputMode::CLEAR : Timer::CompareOutputMode::DISCONNECTED;
+
+            if (channel == Channel::A)
+            {
+                Timer::OCA_Pin::low();
+                Timer::setCompareOutputModeA(compareOutputMode);
+            }
+            else
+            {
+                Timer::OCB_Pin::low();
+                Timer::setCompareOutputModeB(compareOutputMode);
+            }
+        }
+
+        /**
+        @brief Timer overflow handler. Computes the next sample of both channels
+        @note This method has to be called from Timer::handleOVF()
+        */
+        static void handleOverflow() __attribute__((always_inline))
+        {
+            const uint32_t phaseA = s_phases[0] + s_tuningWords[0];
+            s_phases[0] = phaseA;
+            Timer::writeCompareA(pgm_read_byte(s_wavetables[0] + static_cast<uint8_t>(phaseA >> 24)));
+
+            const uint32_t phaseB = s_phases[1] + s_tuningWords[1];
+            s_phases[1] = phaseB;
+            Timer::writeCompareB(pgm_read_byte(s_wavetables[1] + static_cast<uint8_t>(phaseB >> 24)));
+        }
+
+        private:
+
+        // Tuning word per Hz = 2^32 / sample rate = 2^40 / F_CPU, split into integer part and 16-bit fraction
+        static constexpr uint64_t c_tuningWordNum = static_cast<uint64_t>(1) << 40;
+        static constexpr uint32_t c_tuningWordPerHz = c_tuningWordNum / t_cpuClock;
+        static constexpr uint32_t c_tuningWordPerHzFraction = ((c_tuningWordNum % t_cpuClock) << 16) / t_cpuClock;
+
+        // Phase accumulators
+        inline static volatile uint32_t s_phases[2];
+
+        // Phase increments per sample
+        inline static volatile uint32_t s_tuningWords[2];
+
+        // Wavetables in program memory
+        inline static const uint8_t* volatile s_wavetables[2];
+    };
+}
+
+#endif
@@ -0,0 +1,728 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_DSP_H
+#define M328P_DSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+namespace m328p
+{
+    /**
+    @brief Fixed-point arithmetic for the DSP kernels
+    Samples are signed fractional numbers: Q15 (int16_t) or Q7 (int8_t). ADC results are converted by toQ15() and toQ7(),
+    unsigned AD conversion results being interpreted as offset binary with the mid-scale value as zero.
+    */
+    class DSP
+    {
+        public:
+
+        /**
+        @brief Signed 16 x 16 bit multiplication
+        The compiler calls a library routine for 32-bit products, so the hardware multiplier is used directly (20 cycles)
+        @param a Factor
+        @param b Factor
+        @result 32-bit product
+        */
+        static int32_t multiply(const int16_t a, const int16_t b) __attribute__((always_inline))
+        {
+#ifdef __AVR_HAVE_MUL__
+            int32_t product;
+            uint8_t zero;
+            __asm__ (
+            "clr %[zero]"             "\n\t"
+            "muls %B[a], %B[b]"       "\n\t"
+            "movw %C[product], r0"    "\n\t"
+            "mul %A[a], %A[b]"        "\n\t"
+            "movw %A[product], r0"    "\n\t"
+            "mulsu %B[a], %A[b]"      "\n\t"
+            "sbc %D[product], %[zero]" "\n\t"
+            "add %B[product], r0"     "\n\t"
+            "adc %C[product], r1"     "\n\t"
+            "adc %D[product], %[zero]" "\n\t"
+            "mulsu %B[b], %A[a]"      "\n\t"
+            "sbc %D[product], %[zero]" "\n\t"
+            "add %B[product], r0"     "\n\t"
+            "adc %C[product], r1"     "\n\t"
+            "adc %D[product], %[zero]" "\n\t"
+            "clr __zero_reg__"
+            : [product] "=&r" (product), [zero] "=&r" (zero)
+            : [a] "a" (a), [b] "a" (b));
+            return product;
+#else
+            return static_cast<int32_t>(a) * b;
+#endif
+        }
+
+        /**
+        @brief Signed 16 x 16 bit multiplication with 32-bit accumulation
+        The product is added to the accumulator within the multiplication (24 cycles)
+        @param accumulator Accumulator
+        @param a Factor
+        @param b Factor
+        @result accumulator + a * b
+        */
+        static int32_t multiplyAccumulate(int32_t accumulator, const int16_t a, const int16_t b) __attribute__((always_inline))
+        {
+#ifdef __AVR_HAVE_MUL__
+            uint8_t zero;
+            __asm__ (
+            "clr %[zero]"                 "\n\t"
+            "muls %B[a], %B[b]"           "\n\t"
+            "add %C[accumulator], r0"     "\n\t"
+            "adc %D[accumulator], r1"     "\n\t"
+            "mul %A[a], %A[b]"            "\n\t"
+            "add %A[accumulator], r0"     "\n\t"
+            "adc %B[accumulator], r1"     "\n\t"
+            "adc %C[accumulator], %[zero]" "\n\t"
+            "adc %D[accumulator], %[zero]" "\n\t"
+            "mulsu %B[a], %A[b]"          "\n\t"
+            "sbc %D[accumulator], %[zero]" "\n\t"
+            "add %B[accumulator], r0"     "\n\t"
+            "adc %C[accumulator], r1"     "\n\t"
+            "adc %D[accumulator], %[zero]" "\n\t"
+            "mulsu %B[b], %A[a]"          "\n\t"
+            "sbc %D[accumulator], %[zero]" "\n\t"
+            "add %B[accumulator], r0"     "\n\t"
+            "adc %C[accumulator], r1"     "\n\t"
+            "adc %D[accumulator], %[zero]" "\n\t"
+            "clr __zero_reg__"
+            : [accumulator] "+r" (accumulator), [zero] "=&r" (zero)
+            : [a] "a" (a), [b] "a" (b));
+            return accumulator;
+#else
+            return accumulator + static_cast<int32_t>(a) * b;
+#endif
+        }
+
+        /**
+        @brief Signed 8 x 8 bit multiplication with 16-bit accumulation
+        The compiler emits a single MULS instruction for 8-bit factors
+        @param accumulator Accumulator
+        @param a Factor
+        @param b Factor
+        @result accumulator + a * b
+        */
+        static int16_t multiplyAccumulate(const int16_t accumulator, const int8_t a, const int8_t b) __attribute__((always_inline))
+        {
+            return accumulator + static_cast<int16_t>(a) * b;
+        }
+
+        /**
+        @brief Convert a right-aligned 10-bit AD conversion result into Q15
+        @param value AD conversion result (0..1023)
+        @result Q15 value
+        */
+        static constexpr int16_t toQ15(const uint16_t value)
+        {
+            return static_cast<int16_t>((value - 512) << 6);
+        }
+
+        /**
+        @brief Convert a left-aligned 8-bit AD conversion result into Q15
+        @param value AD conversion result (0..255)
+        @result Q15 value
+        */
+        static constexpr int16_t toQ15(const uint8_t value)
+        {
+            return static_cast<int16_t>((value - 128) << 8);
+        }
+
+        /**
+        @brief Pass a Q15 value
+        @param value Q15 value
+        @result Q15 value
+        */
+        static constexpr int16_t toQ15(const int16_t value)
+        {
+            return value;
+        }
+
+        /**
+        @brief Convert a right-aligned 10-bit AD conversion result into Q7
+        @param value AD conversion result (0..1023)
+        @result Q7 value
+        */
+        static constexpr int8_t toQ7(const uint16_t value)
+        {
+            return static_cast<int8_t>((value >> 2) - 128);
+        }
+
+        /**
+        @brief Convert a left-aligned 8-bit AD conversion result into Q7
+        @param value AD conversion result (0..255)
+        @result Q7 value
+        */
+        static constexpr int8_t toQ7(const uint8_t value)
+        {
+            return static_cast<int8_t>(value - 128);
+        }
+
+        /**
+        @brief Pass a Q7 value
+        @param value Q7 value
+        @result Q7 value
+        */
+        static constexpr int8_t toQ7(const int8_t value)
+        {
+            return value;
+        }
+
+        /**
+        @brief Round and saturate an accumulator to Q15
+        @tparam t_shift Number of fractional bits to be removed
+        @param accumulator Accumulator including the rounding offset 1 << (t_shift - 1)
+        @result Q15 value
+        */
+        template <uint8_t t_shift>
+        static int16_t saturateQ15(const int32_t accumulator)
+        {
+            const int32_t value = accumulator >> t_shift;
+            if (value > INT16_MAX)
+            {
+                return INT16_MAX;
+            }
+            if (value < INT16_MIN)
+            {
+                return INT16_MIN;
+            }
+            return static_cast<int16_t>(value);
+        }
+
+        /**
+        @brief Round and saturate an accumulator to Q7
+        @tparam t_shift Number of fractional bits to be removed
+        @param accumulator Accumulator including the rounding offset 1 << (t_shift - 1)
+        @result Q7 value
+        */
+        template <uint8_t t_shift>
+        static int8_t saturateQ7(const int16_t accumulator)
+        {
+            const int16_t value = accumulator >> t_shift;
+            if (value > INT8_MAX)
+            {
+                return INT8_MAX;
+            }
+            if (value < INT8_MIN)
+            {
+                return INT8_MIN;
+            }
+            return static_cast<int8_t>(value);
+        }
+    };
+
+    /**
+    @brief Fixed-point format of a sample type
+    @tparam Sample Sample type: int16_t (Q15) or int8_t (Q7)
+    */
+    template <typename Sample>
+    struct DSPFormat;
+
+    template <>
+    struct DSPFormat<int16_t>
+    {
+        /// Accumulator for sums of products
+        typedef int32_t Accumulator;
+
+        /// Number of fractional bits
+        static constexpr uint8_t c_fractionalBits = 15;
+
+        /// Convert an input sample
+        template <typename Input>
+        static constexpr int16_t convert(const Input input)
+        {
+            return DSP::toQ15(input);
+        }
+
+        /// Round and saturate a sum of products
+        static int16_t saturate(const Accumulator accumulator) __attribute__((always_inline))
+        {
+            return DSP::saturateQ15<c_fractionalBits>(accumulator);
+        }
+    };
+
+    template <>
+    struct DSPFormat<int8_t>
+    {
+        /// Accumulator for sums of products
+        typedef int16_t Accumulator;
+
+        /// Number of fractional bits
+        static constexpr uint8_t c_fractionalBits = 7;
+
+        /// Convert an input sample
+        template <typename Input>
+        static constexpr int8_t convert(const Input input)
+        {
+            return DSP::toQ7(input);
+        }
+
+        /// Round and saturate a sum of products
+        static int8_t saturate(const Accumulator accumulator) __attribute__((always_inline))
+        {
+            return DSP::saturateQ7<c_fractionalBits>(accumulator);
+        }
+    };
+
+    /**
+    @brief FIR filter for Q15 or Q7 samples
+    The delay line is stored twice, so the convolution runs over a contiguous window without index wrapping.
+
+    Usage:
+    @code
+    // 5-tap low-pass filter in Q15
+    static const int16_t c_coefficients[5] = {2621, 7864, 11796, 7864, 2621};
+    static m328p::FIR<int16_t, 5> filter(c_coefficients);
+
+    // Filter a block of right-aligned ADC samples, e.g. obtained from ADCSampler::getBlock()
+    int16_t output[Sampler::getBlockSize()];
+    filter.process(block, output, Sampler::getBlockSize());
+    @endcode
+
+    @tparam Sample Sample and coefficient type: int16_t (Q15) or int8_t (Q7)
+    @tparam t_tapCount Number of filter coefficients
+    @note For Q7 samples, the sum of the absolute coefficient values must not exceed 1.0 to avoid overflows of the 16-bit accumulator
+    */
+    template <typename Sample, uint8_t t_tapCount>
+    class FIR
+    {
+        static_assert(t_tapCount > 0 && t_tapCount <= 127, "FIR supports 1 to 127 taps!");
+
+        typedef DSPFormat<Sample> Format;
+        typedef typename Format::Accumulator Accumulator;
+
+        public:
+
+        /**
+        @brief Constructor
+        @param coefficients Filter coefficients, starting with the coefficient of the latest sample. The array has to remain valid
+        */
+        explicit FIR(const Sample (&coefficients)[t_tapCount]) :
+        m_coefficients(coefficients)
+        {
+            reset();
+        }
+
+        /**
+        @brief Clear the delay line
+        */
+        void reset()
+        {
+            for (Sample& sample : m_delayLine)
+            {
+                sample = 0;
+            }
+            m_index = 0;
+        }
+
+        /**
+        @brief Filter one sample
+        @param input Input sample
+        @result Output sample
+        */
+        Sample process(const Sample input)
+        {
+            // The latest sample is stored at m_index, older samples follow
+            uint8_t index = m_index;
+            index = (index == 0) ? t_tapCount - 1 : index - 1;
+            m_index = index;
+            m_delayLine[index] = input;
+            m_delayLine[index + t_tapCount] = input;
+
+            const Sample* sample = &m_delayLine[index];
+            const Sample* coefficient = m_coefficients;
+            Accumulator accumulator = static_cast<Accumulator>(1) << (Format::c_fractionalBits - 1);
+            for (uint8_t tap = t_tapCount; tap != 0; --tap)
+            {
+                accumulator = DSP::multiplyAccumulate(accumulator, *sample++, *coefficient++);
+            }
+
+            return Format::saturate(accumulator);
+        }
+
+        /**
+        @brief Filter a block of samples
+        @tparam Input Input sample type: Sample, or AD conversion results (uint16_t right-aligned, uint8_t left-aligned)
+        @param input Input samples
+        @param output Output samples. May be identical to input if the types match
+        @param count Number of samples
+        */
+        template <typename Input>
+        void process(const Input* input, Sample* output, uint8_t count)
+        {
+            while (count-- != 0)
+            {
+                *output++ = process(Format::convert(*input++));
+            }
+        }
+
+        private:
+
+        // Filter coefficients
+        const Sample* const m_coefficients;
+
+        // Delay line, stored twice
+        Sample m_delayLine[2 * t_tapCount];
+
+        // Position of the latest sample in the delay line
+        uint8_t m_index;
+    };
+
+    /**
+    @brief Biquad IIR filter section for Q15 samples in direct form I
+    y[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] - a1 * y[n-1] - a2 * y[n-2]
+    The coefficients are given in Q14, so values in the range [-2, 2) can be represented. Higher order filters are built
+    from cascaded sections.
+
+    Usage:
+    @code
+    // Low-pass filter, fc = fs / 10, Q = 0.707
+    static m328p::Biquad filter({1105, 2210, 1105, -18727, 6764});
+
+    int16_t output[Sampler::getBlockSize()];
+    filter.process(block, output, Sampler::getBlockSize());
+    @endcode
+    */
+    class Biquad
+    {
+        public:
+
+        ///@brief Filter coefficients in Q14 with a0 = 1
+        struct Coefficients
+        {
+            int16_t b0;
+            int16_t b1;
+            int16_t b2;
+            int16_t a1;
+            int16_t a2;
+        };
+
+        /**
+        @brief Constructor
+        @param coefficients Filter coefficients in Q14. a1 and a2 must be greater than -2
+        */
+        explicit Biquad(const Coefficients& coefficients) :
+        m_b0(coefficients.b0),
+        m_b1(coefficients.b1),
+        m_b2(coefficients.b2),
+        m_a1(-coefficients.a1),
+        m_a2(-coefficients.a2)
+        {
+            reset();
+        }
+
+        /**
+        @brief Clear the filter state
+        */
+        void reset()
+        {
+            m_x1 = 0;
+            m_x2 = 0;
+            m_y1 = 0;
+            m_y2 = 0;
+        }
+
+        /**
+        @brief Filter one sample
+        @param input Input sample in Q15
+        @result Output sample in Q15
+        */
+        int16_t process(const int16_t input)
+        {
+            int32_t accumulator = static_cast<int32_t>(1) << (c_coefficientBits - 1);
+            accumulator = DSP::multiplyAccumulate(accumulator, m_b0, input);
+            accumulator = DSP::multiplyAccumulate(accumulator, m_b1, m_x1);
+            accumulator = DSP::multiplyAccumulate(accumulator, m_b2, m_x2);
+            accumulator = DSP::multiplyAccumulate(accumulator, m_a1, m_y1);
+            accumulator = DSP::multiplyAccumulate(accumulator, m_a2, m_y2);
+            const int16_t output = DSP::saturateQ15<c_coefficientBits>(accumulator);
+
+            m_x2 = m_x1;
+            m_x1 = input;
+            m_y2 = m_y1;
+            m_y1 = output;
+            return output;
+        }
+
+        /**
+        @brief Filter a block of samples
+        @tparam Input Input sample type: int16_t (Q15), or AD conversion results (uint16_t right-aligned, uint8_t left-aligned)
+        @param input Input samples
+        @param output Output samples in Q15. May be identical to input if the types match
+        @param count Number of samples
+        */
+        template <typename Input>
+        void process(const Input* input, int16_t* output, uint8_t count)
+        {
+            while (count-- != 0)
+            {
+                *output++ = process(DSP::toQ15(*input++));
+            }
+        }
+
+        private:
+
+        // Number of fractional bits of the coefficients
+        static constexpr uint8_t c_coefficientBits = 14;
+
+        // Feed-forward coefficients
+        const int16_t m_b0;
+        const int16_t m_b1;
+        const int16_t m_b2;
+
+        // Negated feedback coefficients
+        const int16_t m_a1;
+        const int16_t m_a2;
+
+        // Delayed input samples
+        int16_t m_x1;
+        int16_t m_x2;
+
+        // Delayed output samples
+        int16_t m_y1;
+        int16_t m_y2;
+    };
+
+    /**
+    @brief Running average over a power-of-two number of samples
+    The sum is updated by adding the new sample and subtracting the oldest one, so the cost per sample does not depend on
+    the length.
+    @tparam Sample Sample type: Signed or unsigned 8-bit or 16-bit integer, e.g. AD conversion results
+    @tparam t_length Number of averaged samples (power of two). Up to 128 for 8-bit samples
+    */
+    template <typename Sample, uint8_t t_length>
+    class RunningAverage
+    {
+        static_assert(t_length >= 2 && (t_length & (t_length - 1)) == 0, "Length must be a power of two!");
+        static_assert(sizeof(Sample) <= 2, "RunningAverage supports 8-bit and 16-bit samples!");
+
+        public:
+
+        /**
+        @brief Constructor
+        @param initialValue Initial value of all samples
+        */
+        explicit RunningAverage(const Sample initialValue = 0)
+        {
+            reset(initialValue);
+        }
+
+        /**
+        @brief Fill all samples with a given value
+        @param value Value of all samples
+        */
+        void reset(const Sample value = 0)
+        {
+            for (Sample& sample : m_samples)
+            {
+                sample = value;
+            }
+            m_sum = static_cast<Accumulator>(value) * t_length;
+            m_index = 0;
+        }
+
+        /**
+        @brief Add one sample
+        @param input Input sample
+        @result Average of the latest t_length samples (rounded down)
+        */
+        Sample process(const Sample input)
+        {
+            const uint8_t index = m_index;
+            m_sum += static_cast<Accumulator>(input) - m_samples[index];
+            m_samples[index] = input;
+            m_index = (index + 1) & (t_length - 1);
+            return static_cast<Sample>(m_sum >> c_shift);
+        }
+
+        /**
+        @brief Process a block of samples
+        @param input Input samples
+        @param output Averaged samples. May be identical to input
+        @param count Number of samples
+        */
+        void process(const Sample* input, Sample* output, uint8_t count)
+        {
+            while (count-- != 0)
+            {
+                *output++ = process(*input++);
+            }
+        }
+
+        private:
+
+        // Sum type. 16 bits hold up to 128 8-bit samples
+        template <bool t_wide, typename Dummy = void>
+        struct AccumulatorType
+        {
+            typedef int32_t Type;
+        };
+
+        template <typename Dummy>
+        struct AccumulatorType<false, Dummy>
+        {
+            typedef int16_t Type;
+        };
+
+        typedef typename AccumulatorType<(sizeof(Sample) > 1)>::Type Accumulator;
+        static_assert(sizeof(Sample) > 1 || t_length <= 128, "Up to 128 8-bit samples can be averaged!");
+
+        // Division by t_length
+        static constexpr uint8_t c_shift = __builtin_ctz(t_length);
+
+        // Latest samples
+        Sample m_samples[t_length];
+
+        // Sum of the latest samples
+        Accumulator m_sum;
+
+        // Position of the oldest sample
+        uint8_t m_index;
+    };
+
+    /**
+    @brief Cascaded integrator-comb (CIC) decimator
+    A multiplier-free low-pass filter with decimation. The integrators run at the input rate, the combs at the output rate.
+    The registers wrap around, which is compensated by the combs, so no overflow handling is required. The gain of
+    t_decimation ^ t_order is removed by a shift, so the output has the scale of the input.
+
+    Usage:
+    @code
+    // Third-order decimation of raw ADC samples by 8
+    static m328p::CIC<uint16_t, 3, 8> decimator;
+
+    uint16_t output[Sampler::getBlockSize() / 8];
+    const uint8_t count = decimator.process(block, output, Sampler::getBlockSize());
+    @endcode
+
+    @tparam Sample Sample type: Signed or unsigned 8-bit or 16-bit integer, e.g. AD conversion results
+    @tparam t_order Number of integrator and comb stages (1..4)
+    @tparam t_decimation Decimation factor (power of two)
+    */
+    template <typename Sample, uint8_t t_order, uint8_t t_decimation>
+    class CIC
+    {
+        static_assert(t_order >= 1 && t_order <= 4, "CIC supports 1 to 4 stages!");
+        static_assert(t_decimation >= 2 && (t_decimation & (t_decimation - 1)) == 0, "Decimation factor must be a power of two!");
+        static_assert(sizeof(Sample) <= 2, "CIC supports 8-bit and 16-bit samples!");
+
+        public:
+
+        /**
+        @brief Constructor
+        */
+        CIC()
+        {
+            reset();
+        }
+
+        /**
+        @brief Clear the filter state
+        */
+        void reset()
+        {
+            for (uint8_t stage = 0; stage < t_order; ++stage)
+            {
+                m_integrators[stage] = 0;
+                m_combs[stage] = 0;
+            }
+            m_phase = 0;
+        }
+
+        /**
+        @brief Process one input sample
+        @param input Input sample
+        @param output Output sample, only written if an output sample is available
+        @result Flag indicating an output sample has been written
+        */
+        bool process(const Sample input, Sample& output)
+        {
+            // Signed samples are sign-extended
+            uint32_t value = static_cast<uint32_t>(static_cast<int32_t>(input));
+            for (uint8_t stage = 0; stage < t_order; ++stage)
+            {
+                value += m_integrators[stage];
+                m_integrators[stage] = value;
+            }
+
+            if (++m_phase != t_decimation)
+            {
+                return false;
+            }
+            m_phase = 0;
+
+            for (uint8_t stage = 0; stage < t_order; ++stage)
+            {
+                const uint32_t delayed = m_combs[stage];
+                m_combs[stage] = value;
+                value -= delayed;
+            }
+
+            // Unsigned samples may use all 32 bits of the registers, so they must not be shifted as signed value
+            if (c_signed)
+            {
+                output = static_cast<Sample>(static_cast<int32_t>(value) >> c_shift);
+            }
+            else
+            {
+                output = static_cast<Sample>(value >> c_shift);
+            }
+            return true;
+        }
+
+        /**
+        @brief Process a block of samples
+        @param input Input samples
+        @param output Output samples, one per t_decimation input samples. May be identical to input
+        @param count Number of input samples
+        @result Number of output samples written
+        */
+        uint8_t process(const Sample* input, Sample* output, uint8_t count)
+        {
+            uint8_t outputCount = 0;
+            while (count-- != 0)
+            {
+                if (process(*input++, output[outputCount]))
+                {
+                    ++outputCount;
+                }
+            }
+            return outputCount;
+        }
+
+        private:
+
+        // Removal of the filter gain t_decimation ^ t_order
+        static constexpr uint8_t c_shift = t_order * __builtin_ctz(t_decimation);
+        static_assert(8 * sizeof(Sample) + c_shift <= 32, "Register width exceeded. Reduce order or decimation factor!");
+
+        // Flag indicating the sample type is signed
+        static constexpr bool c_signed = static_cast<Sample>(-1) < 0;
+
+        // Integrator registers
+        uint32_t m_integrators[t_order];
+
+        // Comb delay registers
+        uint32_t m_combs[t_order];
+
+        // Input samples since the last output sample
+        uint8_t m_phase;
+    };
+}
+
+#endif
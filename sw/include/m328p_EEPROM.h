@@ -19,7 +19,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define M328P_EEPROM_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <avr/eeprom.h>
+#include "register_access.h"
+#include "m328p_Atomic.h"
 
 namespace m328p
 {
@@ -31,6 +34,14 @@ namespace m328p
         public:
         
         typedef uint16_t Address;
+
+        ///@brief EEPROM Programming Mode
+        enum class ProgrammingMode : uint8_t
+        {
+            ERASE_WRITE = 0b00, // Atomic operation (approx. 3.4ms)
+            ERASE = 0b01, // Erase only, the byte is set to 0xFF (approx. 1.8ms)
+            WRITE = 0b10 // Write only, bits can only be cleared (approx. 1.8ms)
+        };
         
         /**
         @brief Get EEMEM capacity in bytes
@@ -42,7 +53,7 @@ namespace m328p
         }
         
         /**
-        @brief Copy memory for a given number of elements of given type from EEMEM to RAM.
+        @brief Copy memory for a given number of elements of given type from RAM to EEMEM.
         @tparam Elem Type of the elements to be copied
         @tparam Len Integral length type
         @param dst Destination pointer in EEMEM
@@ -50,7 +61,7 @@ namespace m328p
         @param len length in Elem
         */
         template <typename Elem, typename Len = uint8_t>
-        inline void write(Elem * dst, const Elem * src, const Len len)
+        static void write(Elem * dst, const Elem * src, const Len len)
         {
             eeprom_write_block(
             reinterpret_cast<const uint8_t*>(src),
@@ -59,13 +70,13 @@ namespace m328p
         }
 
         /**
-        @brief Copy memory for one element of given type from EEMEM to RAM.
+        @brief Copy memory for one element of given type from RAM to EEMEM.
         @tparam Elem Type of the elements to be copied
         @param dst Destination pointer in EEMEM
         @param src Source pointer in RAM
         */
         template <typename Elem>
-        inline void write(Elem * dst, const Elem * src)
+        static void write(Elem * dst, const Elem * src)
         {
             eeprom_write_block(
             reinterpret_cast<const uint8_t*>(src),
@@ -82,7 +93,7 @@ namespace m328p
         @param len length in Elem
         */
         template <typename Elem, typename Len = uint8_t>
-        inline void read(Elem * dst, const Elem * src, const Len len)
+        static void read(Elem * dst, const Elem * src, const Len len)
         {
             eeprom_read_block(
             reinterpret_cast<uint8_t*>(dst),
@@ -97,7 +108,7 @@ namespace m328p
         @param src Source pointer in EEMEM
         */
         template <typename Elem>
-        inline void read(Elem * dst, const Elem * src)
+        static void read(Elem * dst, const Elem * src)
         {
             eeprom_read_block(
             reinterpret_cast<uint8_t*>(dst),
@@ -150,15 +161,129 @@ namespace m328p
         {
             eeprom_read_block(data, getBufferPointer(pos), nofBytes);
         }
+
+        /**
+        @brief Check if the EEPROM is ready for a new read or write access
+        @result Flag indicating no write operation is in progress
+        */
+        [[nodiscard]] static bool isReady() __attribute__((always_inline))
+        {
+            return !EEPE_bit::read();
+        }
+
+        /**
+        @brief Write one byte to EEMEM at given position only if it differs from the stored byte
+        The cheapest programming mode is selected, so unchanged bytes are not programmed at all and erase or write only
+        operations are used where possible. This saves programming time and cell wear
+        @param pos Position in EEMEM (0..1023)
+        @param data Byte to be written to EEMEM
+        @result Flag indicating the byte has been programmed
+        @note This method does not wait for the completion of the programming
+        */
+        static bool update(const Address pos, const uint8_t data)
+        {
+            const uint8_t current = read(pos);
+            if (current == data)
+            {
+                return false;
+            }
+
+            startWrite(pos, data, selectProgrammingMode(current, data));
+            return true;
+        }
+
+        /**
+        @brief Write multiple Bytes to EEMEM starting from given position. Only bytes differing from the stored bytes are programmed
+        @param pos Position of first byte in EEMEM (0..1023)
+        @param data Bytes to be written to EEMEM
+        @param nofBytes Number of Bytes to be written to EEMEM (1..1024)
+        @result Number of programmed bytes
+        */
+        static Address update(const Address pos, const void * data, const Address nofBytes)
+        {
+            const uint8_t * src = static_cast<const uint8_t*>(data);
+            Address nofProgrammedBytes = 0;
+            for (Address offset = 0; offset < nofBytes; ++offset)
+            {
+                if (update(pos + offset, src[offset]))
+                {
+                    ++nofProgrammedBytes;
+                }
+            }
+            return nofProgrammedBytes;
+        }
+
+        /**
+        @brief Select the fastest programming mode changing a stored byte into a new byte
+        @param current Stored byte
+        @param data New byte
+        @result Programming mode. Write only, if no bit has to be changed from 0 to 1. Erase only, if the new byte is 0xFF
+        */
+        [[nodiscard]] static constexpr ProgrammingMode selectProgrammingMode(const uint8_t current, const uint8_t data)
+        {
+            return
+            data == 0xFF ? ProgrammingMode::ERASE :
+            (current & data) == data ? ProgrammingMode::WRITE :
+            ProgrammingMode::ERASE_WRITE;
+        }
+
+        /**
+        @brief Start programming one byte to EEMEM at given position without waiting for its completion
+        The EEPROM ready interrupt (if enabled) is triggered as soon as the byte has been programmed
+        @param pos Position in EEMEM (0..1023)
+        @param data Byte to be written to EEMEM. Ignored if the byte is erased only
+        @param mode Programming mode
+        @note If a write operation is in progress, this method waits for its completion
+        */
+        static void startWrite(const Address pos, const uint8_t data, const ProgrammingMode mode = ProgrammingMode::ERASE_WRITE)
+        {
+            while (!isReady());
+
+            // EEPE has to be set within four clock cycles after EEMPE, so interrupts are disabled during the sequence
+            Atomic atomic;
+            EEAR::write(reinterpret_cast<uintptr_t>(getBufferPointer(pos)));
+            EEDR::write(data);
+            EECR::write((EECR::read() & _BV(EERIE)) | (static_cast<uint8_t>(mode) << EEPM0) | _BV(EEMPE));
+            EEPE_bit::set();
+        }
+
+        /**
+        @brief Enable the EEPROM ready interrupt
+        @note The interrupt is triggered continuously as long as the EEPROM is ready, so it has to be disabled when idle
+        */
+        static void enableReadyInterrupt() __attribute__((always_inline))
+        {
+            EERIE_bit::set();
+        }
+
+        /**
+        @brief Disable the EEPROM ready interrupt
+        */
+        static void disableReadyInterrupt() __attribute__((always_inline))
+        {
+            EERIE_bit::clear();
+        }
         
         private:
 
+        // EEPROM Write Enable
+        typedef BitInRegister<EECR, EEPE> EEPE_bit;
+
+        // EEPROM Ready Interrupt Enable
+        typedef BitInRegister<EECR, EERIE> EERIE_bit;
+
         // Workaround to avoid an extra cpp file for just the definition of this static buffer
         [[nodiscard]] static uint8_t * getBufferPointer(const Address offset)
         {
             static uint8_t auiBuffer[capacity()] EEMEM;
             return auiBuffer + (offset & (capacity()-1));
         }
+
+        /**
+        @brief EEPROM ready interrupt handler
+        @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
+        */
+        static void handleReadyInterrupt() __asm__("__vector_22") __attribute__((__signal__, __used__, __externally_visible__));
     };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,398 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_EEPROMSTORE_H
+#define M328P_EEPROMSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <util/crc16.h>
+#include "m328p_EEPROM.h"
+
+namespace m328p
+{
+    /**
+    @brief Wear-levelled key/value store in EEMEM (internal EEPROM)
+    The memory is organized as a circular log of fixed-size slots. Every write appends a record containing a sequence number,
+    the key, the value and a CRC to the next free slot, so the writes are spread across all slots instead of wearing out
+    the cells of frequently written values.
+
+    At initialization, all slots are scanned once and an index holding the slot of the latest valid record per key is built
+    in RAM. Hence, reads access the record directly. Garbage collection is implicit: records superseded by a newer record of
+    the same key are stale and their slots are reused when the log wraps around, while slots holding the latest record of a
+    key are skipped. A record interrupted by a power loss fails the CRC check, so the previous record of the key stays valid.
+
+    Usage:
+    @code
+    typedef m328p::EEPROMStore<4, 8> Store;
+
+    enum Key : uint8_t {BOOT_COUNT, ...};
+
+    int main()
+    {
+        Store::init();
+
+        uint32_t bootCount = 0;
+        Store::read(BOOT_COUNT, bootCount);
+        ++bootCount;
+        Store::write(BOOT_COUNT, bootCount);
+        ...
+    }
+    @endcode
+
+    @tparam t_valueSize Maximum size of a value in bytes
+    @tparam t_keyCount Number of keys (keys are 0..t_keyCount-1)
+    @tparam t_begin Position of the first byte of the store in EEMEM
+    @tparam t_size Size of the store in bytes. The more slots exceed the number of keys, the better the wear is spread
+    */
+    template <
+    uint8_t t_valueSize = 8,
+    uint8_t t_keyCount = 16,
+    EEPROM::Address t_begin = 0,
+    EEPROM::Address t_size = EEPROM::capacity()>
+    class EEPROMStore
+    {
+        // Record stored in one slot
+        struct Record
+        {
+            uint32_t sequence; // Sequence number, incremented with every written record
+            uint8_t key;
+            uint8_t length; // Length of the value or c_removed
+            uint8_t value[t_valueSize];
+            uint16_t crc; // CRC-CCITT of all preceding bytes
+        };
+
+        // Slot index indicating no slot
+        static constexpr uint8_t c_none = 0xFF;
+
+        // Length marking a removal record
+        static constexpr uint8_t c_removed = 0xFF;
+
+        // Number of slots
+        static constexpr uint16_t c_slotCount = t_size / sizeof(Record);
+
+        static_assert(t_valueSize > 0 && t_valueSize < 0xFF, "Invalid value size!");
+        static_assert(t_keyCount > 0 && t_keyCount < 0xFF, "Invalid number of keys: The store supports 1 to 254 keys!");
+        static_assert(static_cast<uint32_t>(t_begin) + t_size <= EEPROM::capacity(), "Store exceeds EEPROM capacity!");
+        static_assert(c_slotCount > t_keyCount, "Store too small: At least one slot more than keys is required!");
+        static_assert(c_slotCount < c_none, "Too many slots: Increase the value size!");
+
+        public:
+
+        /**
+        @brief Initialization. All slots are scanned and the index is built
+        */
+        static void init()
+        {
+            memset(s_index, c_none, sizeof(s_index));
+            memset(s_used, 0, sizeof(s_used));
+
+            uint8_t latestSlot = c_none;
+            uint32_t latestSequence = 0;
+
+            for (uint8_t slot = 0; slot < c_slotCount; ++slot)
+            {
+                Record record;
+                if (!readRecord(slot, record))
+                {
+                    continue;
+                }
+
+                const uint8_t indexedSlot = s_index[record.key];
+                if (indexedSlot == c_none || record.sequence > readSequence(indexedSlot))
+                {
+                    if (indexedSlot != c_none)
+                    {
+                        setUsed(indexedSlot, false);
+                    }
+                    s_index[record.key] = slot;
+                    setUsed(slot, true);
+                }
+
+                if (latestSlot == c_none || record.sequence > latestSequence)
+                {
+                    latestSlot = slot;
+                    latestSequence = record.sequence;
+                }
+            }
+
+            // The log continues after the latest record
+            if (latestSlot == c_none)
+            {
+                s_head = 0;
+                s_sequence = 0;
+            }
+            else
+            {
+                s_head = nextSlot(latestSlot);
+                s_sequence = latestSequence + 1;
+            }
+        }
+
+        /**
+        @brief Read the value of a key
+        @param key Key (0..t_keyCount-1)
+        @param value Buffer for the value (t_valueSize bytes)
+        @param length Length of the value in bytes
+        @result Flag indicating a value is stored for the given key
+        */
+        static bool read(const uint8_t key, void * value, uint8_t & length)
+        {
+            const uint8_t slot = getSlot(key);
+            if (slot == c_none)
+            {
+                return false;
+            }
+
+            length = EEPROM::read(getPosition(slot) + offsetof(Record, length));
+            if (length == c_removed)
+            {
+                return false;
+            }
+
+            EEPROM::read(getPosition(slot) + offsetof(Record, value), value, length);
+            return true;
+        }
+
+        /**
+        @brief Read the value of a key into an object of given type
+        @tparam Value Type of the value
+        @param key Key (0..t_keyCount-1)
+        @param value Value read from the store. Not modified if no value of matching size is stored
+        @result Flag indicating a value of matching size is stored for the given key
+        */
+        template <typename Value>
+        static bool read(const uint8_t key, Value & value)
+        {
+            static_assert(sizeof(Value) <= t_valueSize, "Value exceeds value size of the store!");
+
+            uint8_t buffer[t_valueSize];
+            uint8_t length = 0;
+            if (!read(key, buffer, length) || length != sizeof(Value))
+            {
+                return false;
+            }
+
+            memcpy(&value, buffer, sizeof(Value));
+            return true;
+        }
+
+        /**
+        @brief Write the value of a key. Nothing is programmed if the value is unchanged
+        @param key Key (0..t_keyCount-1)
+        @param value Value to be written
+        @param length Length of the value in bytes (0..t_valueSize)
+        @result Flag indicating the value has been stored. False if key or length are invalid
+        */
+        static bool write(const uint8_t key, const void * value, const uint8_t length)
+        {
+            if (key >= t_keyCount || length > t_valueSize)
+            {
+                return false;
+            }
+
+            // Compare with the stored value to avoid unnecessary wear
+            const uint8_t slot = s_index[key];
+            if (slot != c_none)
+            {
+                Record record;
+                EEPROM::read(getPosition(slot), &record, sizeof(Record));
+                if (record.length == length && memcmp(record.value, value, length) == 0)
+                {
+                    return true;
+                }
+            }
+
+            append(key, value, length);
+            return true;
+        }
+
+        /**
+        @brief Write the value of a key from an object of given type
+        @tparam Value Type of the value
+        @param key Key (0..t_keyCount-1)
+        @param value Value to be written
+        @result Flag indicating the value has been stored. False if the key is invalid
+        */
+        template <typename Value>
+        static bool write(const uint8_t key, const Value & value)
+        {
+            static_assert(sizeof(Value) <= t_valueSize, "Value exceeds value size of the store!");
+            return write(key, &value, sizeof(Value));
+        }
+
+        /**
+        @brief Remove the value of a key
+        @param key Key (0..t_keyCount-1)
+        @note A removal record is written, which occupies a slot like a value
+        */
+        static void remove(const uint8_t key)
+        {
+            if (!contains(key))
+            {
+                return;
+            }
+
+            append(key, nullptr, c_removed);
+        }
+
+        /**
+        @brief Check if a value is stored for a key
+        @param key Key (0..t_keyCount-1)
+        @result Flag indicating a value is stored for the given key
+        */
+        [[nodiscard]] static bool contains(const uint8_t key)
+        {
+            const uint8_t slot = getSlot(key);
+            return slot != c_none && EEPROM::read(getPosition(slot) + offsetof(Record, length)) != c_removed;
+        }
+
+        /**
+        @brief Get the number of slots
+        @result Number of slots in the store
+        */
+        static constexpr uint16_t getSlotCount()
+        {
+            return c_slotCount;
+        }
+
+        /**
+        @brief Get the sequence number of the next record
+        @result Number of records written since the store has been erased
+        */
+        [[nodiscard]] static uint32_t getSequence()
+        {
+            return s_sequence;
+        }
+
+        private:
+
+        // Write a new record to the next free slot and update the index
+        static void append(const uint8_t key, const void * value, const uint8_t length)
+        {
+            // Slots holding the latest record of a key must not be overwritten
+            uint8_t slot = s_head;
+            while (isUsed(slot))
+            {
+                slot = nextSlot(slot);
+            }
+
+            Record record;
+            memset(&record, 0xFF, sizeof(Record));
+            record.sequence = s_sequence;
+            record.key = key;
+            record.length = length;
+            if (length != c_removed)
+            {
+                memcpy(record.value, value, length);
+            }
+            record.crc = calculateCRC(record);
+
+            EEPROM::update(getPosition(slot), &record, sizeof(Record));
+
+            const uint8_t previousSlot = s_index[key];
+            if (previousSlot != c_none)
+            {
+                setUsed(previousSlot, false);
+            }
+            s_index[key] = slot;
+            setUsed(slot, true);
+
+            s_head = nextSlot(slot);
+            s_sequence = s_sequence + 1;
+        }
+
+        // Read the record from a slot and check its validity
+        static bool readRecord(const uint8_t slot, Record & record)
+        {
+            EEPROM::read(getPosition(slot), &record, sizeof(Record));
+            return
+            record.key < t_keyCount &&
+            (record.length <= t_valueSize || record.length == c_removed) &&
+            record.crc == calculateCRC(record);
+        }
+
+        // Read the sequence number of the record in a slot
+        static uint32_t readSequence(const uint8_t slot)
+        {
+            uint32_t sequence;
+            EEPROM::read(getPosition(slot) + offsetof(Record, sequence), &sequence, sizeof(sequence));
+            return sequence;
+        }
+
+        // CRC-CCITT over all bytes of a record preceding the CRC
+        static uint16_t calculateCRC(const Record & record)
+        {
+            const uint8_t * data = reinterpret_cast<const uint8_t*>(&record);
+            uint16_t crc = 0xFFFF;
+            for (uint8_t idx = 0; idx < offsetof(Record, crc); ++idx)
+            {
+                crc = _crc_ccitt_update(crc, data[idx]);
+            }
+            return crc;
+        }
+
+        // Get the slot holding the latest record of a key
+        static uint8_t getSlot(const uint8_t key)
+        {
+            return key < t_keyCount ? s_index[key] : c_none;
+        }
+
+        static constexpr EEPROM::Address getPosition(const uint8_t slot)
+        {
+            return t_begin + static_cast<EEPROM::Address>(slot) * sizeof(Record);
+        }
+
+        static constexpr uint8_t nextSlot(const uint8_t slot)
+        {
+            return slot + 1 < c_slotCount ? slot + 1 : 0;
+        }
+
+        static bool isUsed(const uint8_t slot)
+        {
+            return (s_used[slot >> 3] & (1 << (slot & 7))) != 0;
+        }
+
+        static void setUsed(const uint8_t slot, const bool used)
+        {
+            if (used)
+            {
+                s_used[slot >> 3] |= (1 << (slot & 7));
+            }
+            else
+            {
+                s_used[slot >> 3] &= ~(1 << (slot & 7));
+            }
+        }
+
+        // Slot holding the latest record per key
+        inline static uint8_t s_index[t_keyCount] = {};
+
+        // Flags indicating a slot holds the latest record of a key
+        inline static uint8_t s_used[(c_slotCount + 7) / 8] = {};
+
+        // Next slot to be written
+        inline static uint8_t s_head = 0;
+
+        // Sequence number of the next record
+        inline static uint32_t s_sequence = 0;
+    };
+}
+
+#endif
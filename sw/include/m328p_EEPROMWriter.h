@@ -0,0 +1,223 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_EEPROMWRITER_H
+#define M328P_EEPROMWRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_EEPROM.h"
+#include "m328p_RingBuffer.h"
+
+namespace m328p
+{
+    /**
+    @brief Non-blocking writer for EEMEM (internal EEPROM)
+    Write jobs are queued and programmed in the background, one byte per EEPROM ready interrupt. The CPU is not blocked for the
+    approx. 3.4ms programming time per byte, as it is with the blocking EEPROM::write() methods. Update jobs skip unchanged
+    bytes and use the faster erase only or write only programming modes where possible.
+    The blocking EEPROM methods must not be used while the writer is busy, as they share the EEPROM address register.
+
+    Usage:
+    @code
+    typedef m328p::EEPROMWriter<> Writer;
+
+    static uint8_t settings[16];
+
+    void onSettingsStored()
+    {
+        ...
+    }
+
+    int main()
+    {
+        sei();
+        Writer::write(0x100, settings, sizeof(settings), onSettingsStored);
+
+        while (true)
+        {
+            ...
+        }
+    }
+
+    void m328p::EEPROM::handleReadyInterrupt()
+    {
+        Writer::handleReady();
+    }
+    @endcode
+
+    @tparam t_queueSize Size of the job queue (power of two). One entry is kept free
+    */
+    template <uint8_t t_queueSize = 8>
+    class EEPROMWriter
+    {
+        public:
+
+        ///@brief Function called from the interrupt handler after the last byte of a job has been programmed
+        typedef void (*Callback)();
+
+        /**
+        @brief Queue a write job. Programming starts immediately if the writer is idle
+        @param pos Position of first byte in EEMEM (0..1023)
+        @param data Bytes to be written to EEMEM
+        @param nofBytes Number of Bytes to be written to EEMEM (1..1024)
+        @param onComplete Function called after the job has been completed (optional)
+        @result Flag indicating the job has been queued. False if the queue is full or nofBytes is zero
+        @note The data is not copied, so it has to remain valid and unchanged until the job has been completed
+        */
+        static bool write(
+        const EEPROM::Address pos,
+        const void * data,
+        const EEPROM::Address nofBytes,
+        const Callback onComplete = nullptr)
+        {
+            if (nofBytes == 0)
+            {
+                return false;
+            }
+
+            return queue(Job{pos, static_cast<const uint8_t*>(data), nofBytes, onComplete, false});
+        }
+
+        /**
+        @brief Queue a write job programming only bytes differing from the stored bytes (see EEPROM::update())
+        @param pos Position of first byte in EEMEM (0..1023)
+        @param data Bytes to be written to EEMEM
+        @param nofBytes Number of Bytes to be written to EEMEM (1..1024)
+        @param onComplete Function called after the job has been completed (optional)
+        @result Flag indicating the job has been queued. False if the queue is full or nofBytes is zero
+        @note The data is not copied, so it has to remain valid and unchanged until the job has been completed
+        */
+        static bool update(
+        const EEPROM::Address pos,
+        const void * data,
+        const EEPROM::Address nofBytes,
+        const Callback onComplete = nullptr)
+        {
+            if (nofBytes == 0)
+            {
+                return false;
+            }
+
+            return queue(Job{pos, static_cast<const uint8_t*>(data), nofBytes, onComplete, true});
+        }
+
+        /**
+        @brief Check if a job is in progress or pending
+        @result Flag indicating the writer is busy
+        */
+        [[nodiscard]] static bool isBusy()
+        {
+            return s_active || !s_jobs.isEmpty();
+        }
+
+        /**
+        @brief Wait until all queued jobs have been completed
+        @note Interrupts have to be enabled
+        */
+        static void flush()
+        {
+            while (isBusy());
+        }
+
+        /**
+        @brief Program the next byte. Completed jobs are finished and the next job is started
+        @note This method has to be called from EEPROM::handleReadyInterrupt()
+        */
+        static void handleReady()
+        {
+            while (true)
+            {
+                if (!s_active)
+                {
+                    if (!s_jobs.pop(s_job))
+                    {
+                        // The ready interrupt is level-triggered, so it has to be disabled when idle
+                        EEPROM::disableReadyInterrupt();
+                        return;
+                    }
+                    s_active = true;
+                }
+
+                // Unchanged bytes of update jobs are skipped without programming
+                while (s_job.nofBytes != 0)
+                {
+                    bool programmed = true;
+                    if (s_job.update)
+                    {
+                        programmed = EEPROM::update(s_job.pos, *s_job.data);
+                    }
+                    else
+                    {
+                        EEPROM::startWrite(s_job.pos, *s_job.data);
+                    }
+
+                    ++s_job.pos;
+                    ++s_job.data;
+                    --s_job.nofBytes;
+
+                    if (programmed)
+                    {
+                        return;
+                    }
+                }
+
+                // All bytes of the current job have been programmed
+                s_active = false;
+                if (s_job.onComplete != nullptr)
+                {
+                    s_job.onComplete();
+                }
+            }
+        }
+
+        private:
+
+        // Write job
+        struct Job
+        {
+            EEPROM::Address pos; // Position of the next byte in EEMEM
+            const uint8_t * data; // Next byte to be written
+            EEPROM::Address nofBytes; // Number of remaining bytes
+            Callback onComplete;
+            bool update; // Flag indicating unchanged bytes are skipped
+        };
+
+        // Append a job to the queue and start programming
+        static bool queue(const Job& job)
+        {
+            if (!s_jobs.push(job))
+            {
+                return false;
+            }
+
+            EEPROM::enableReadyInterrupt();
+            return true;
+        }
+
+        // Pending jobs
+        inline static RingBuffer<Job, t_queueSize> s_jobs;
+
+        // Job in progress
+        inline static Job s_job = {};
+
+        // Flag indicating a job is in progress
+        inline static volatile bool s_active = false;
+    };
+}
+
+#endif
@@ -216,6 +216,24 @@ namespace m328p
     {
         public:
 
+        /**
+        @brief Get the GP I/O port of the selected pin
+        @result GP I/O port designator
+        */
+        static constexpr Port getPort()
+        {
+            return t_port;
+        }
+
+        /**
+        @brief Get the index of the selected pin within its GP I/O port
+        @result Pin index (0..7)
+        */
+        static constexpr uint8_t getPinIdx()
+        {
+            return t_pinIdx;
+        }
+
         /**
         @brief Set data direction for the selected pin to input
         */
@@ -0,0 +1,169 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_INPUTCAPTURE_H
+#define M328P_INPUTCAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Timer1.h"
+#include "m328p_GPIO.h"
+#include "m328p_RingBuffer.h"
+
+namespace m328p
+{
+    /**
+    @brief Input capture driver for Timer1
+    Captured ICR1 values are extended to 32-bit time stamps of the system clock and stored in a lock-free ring buffer.
+    Optionally, the trigger edge is flipped after each capture, so consecutive captures alternate between rising and falling
+    edges for pulse width and duty cycle measurement.
+    
+    Usage:
+    @code
+    typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_8> Clock;
+    typedef m328p::InputCapture<Clock, 16> Capture;
+    
+    int main()
+    {
+        Clock::init();
+        Capture::init(m328p::Timer1::InputCaptureEdge::RISING, true, false);
+        sei();
+        
+        Capture::Event first, second;
+        ...
+        if (Capture::read(first) && Capture::read(second))
+        {
+            const uint32_t period = second.timestamp - first.timestamp;
+        }
+    }
+    
+    void m328p::Timer1::handleCAPT()
+    {
+        Capture::handleCapture();
+    }
+    
+    void m328p::Timer1::handleOVF()
+    {
+        Clock::handleOverflow();
+    }
+    @endcode
+    
+    @tparam Clock System clock providing the time base, see SystemClock
+    @tparam t_bufferSize Size of the capture buffer (power of two, 2..128)
+    */
+    template <typename Clock, uint8_t t_bufferSize>
+    class InputCapture
+    {
+        public:
+        
+        /// Input capture event
+        struct Event
+        {
+            /// Time stamp in system clock ticks
+            typename Clock::Ticks timestamp;
+            
+            /// Edge which triggered the capture
+            Timer1::InputCaptureEdge edge;
+        };
+        
+        /// Input capture pin ICP1 (PB0)
+        typedef GPIOPin<Port::B, 0> ICP_Pin;
+        
+        /**
+        @brief Initialization. The system clock has to be initialized beforehand
+        @param edge Edge triggering the first capture
+        @param noiseCanceler Flag indicating the noise canceler is enabled
+        @param toggleEdge Flag indicating the trigger edge is flipped after each capture
+        */
+        static void init(
+        const Timer1::InputCaptureEdge edge,
+        const bool noiseCanceler,
+        const bool toggleEdge)
+        {
+            ICP_Pin::setAsInput();
+            
+            s_toggleEdge = toggleEdge;
+            Timer1::enableInputCaptureNoiseCanceler(noiseCanceler);
+            Timer1::setInputCaptureEdge(edge);
+            Timer1::clearInputCaptureFlag();
+            Timer1::enableInputCaptureInterrupt();
+        }
+        
+        /**
+        @brief Read the oldest capture event
+        @param event Capture event
+        @result Flag indicating an event has been read. False if no event is available
+        */
+        static bool read(Event & event)
+        {
+            return s_buffer.pop(event);
+        }
+        
+        /**
+        @brief Discard all capture events
+        */
+        static void clear()
+        {
+            s_buffer.clear();
+        }
+        
+        /**
+        @brief Get the number of capture events lost due to a full buffer
+        @result Number of lost capture events
+        */
+        [[nodiscard]] static uint8_t getOverrunCount()
+        {
+            return s_overrunCount;
+        }
+        
+        /**
+        @brief Timer1 input capture handler
+        @note This method has to be called from Timer1::handleCAPT()
+        */
+        static void handleCapture()
+        {
+            // Interrupts are disabled, so ICR1 can be read without guard
+            const uint16_t counter = Timer1::readInputCapture();
+            const Timer1::InputCaptureEdge edge = Timer1::getInputCaptureEdge();
+            
+            if (s_toggleEdge)
+            {
+                Timer1::setInputCaptureEdge(
+                (edge == Timer1::InputCaptureEdge::RISING) ? Timer1::InputCaptureEdge::FALLING : Timer1::InputCaptureEdge::RISING);
+                Timer1::clearInputCaptureFlag();
+            }
+            
+            if (!s_buffer.push(Event{Clock::extend(counter), edge}))
+            {
+                s_overrunCount = s_overrunCount + 1;
+            }
+        }
+        
+        private:
+        
+        // Capture event buffer
+        inline static RingBuffer<Event, t_bufferSize> s_buffer;
+        
+        // Flag indicating the trigger edge is flipped after each capture
+        inline static bool s_toggleEdge = false;
+        
+        // Number of lost capture events
+        inline static volatile uint8_t s_overrunCount = 0;
+    };
+}
+
+#endif
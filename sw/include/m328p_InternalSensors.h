@@ -0,0 +1,278 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_INTERNALSENSORS_H
+#define M328P_INTERNALSENSORS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/delay.h>
+#include "m328p_ADC.h"
+#include "m328p_EEPROM.h"
+
+namespace m328p
+{
+    /**
+    @brief Measurement of the supply voltage and the die temperature using the internal ADC channels
+    The supply voltage is derived from a conversion of the internal bandgap reference (VBG) against AVCC. The die temperature
+    is converted from ADC8 against the internal 1.1V reference. All results are fixed-point integers.
+
+    The bandgap voltage (1.0V to 1.2V) and the temperature sensor offset (up to +-10 degrees Celsius) vary from device to
+    device. Calibration values are loaded from EEMEM by init() and can be determined by single-point calibration against a
+    reference measurement. Nominal values are used as long as no calibration has been stored.
+
+    After switching the channel or the reference voltage, the analog input needs time to settle. A settling delay is inserted
+    and the first conversion is discarded. The remaining conversions are accumulated for a resolution of 1/4 LSB.
+
+    Usage:
+    @code
+    typedef m328p::InternalSensors<0x3F0> Sensors;
+
+    int main()
+    {
+        m328p::ADConverter::Reader<uint16_t>::init(m328p::ADConverter::ReferenceSelection::AVCC, m328p::ADConverter::PrescalerSelect::DIV_128,
+        false, false, m328p::ADConverter::AutoTriggerSource::FREE_RUN, true, false, false, false, false, false);
+        Sensors::init();
+
+        const uint16_t supplyVoltage = Sensors::readSupplyVoltage(); // mV
+        const int16_t temperature = Sensors::readTemperature(); // 0.1 degrees Celsius
+
+        m328p::ADConverter::selectChannel(m328p::ADConverter::ChannelSelection::ADC0);
+        m328p::ADConverter::startConversion();
+        m328p::ADConverter::wait();
+        const uint16_t voltage = Sensors::toMillivolts(m328p::ADConverter::Reader<uint16_t>::read(), supplyVoltage);
+        ...
+    }
+    @endcode
+
+    @tparam t_calibrationAddress Position of the calibration values in EEMEM (sizeof(Calibration) bytes)
+    @tparam t_referenceSettlingTime Settling time in us after a change of the reference voltage. With a 100nF capacitor at the
+    AREF pin, the internal 1.1V reference settles within about 5ms
+    @note The ADC has to be initialized and must not be used by any other service (e.g. in auto trigger mode or in interrupt
+    context) at the same time. Reference voltage, channel and result alignment are restored after each measurement
+    */
+    template <EEPROM::Address t_calibrationAddress, uint16_t t_referenceSettlingTime = 5000>
+    class InternalSensors
+    {
+        public:
+
+        ///@brief Calibration values as stored in EEMEM
+        struct Calibration
+        {
+            /// Bandgap voltage in mV
+            uint16_t bandgapVoltage;
+
+            /// Temperature sensor conversion result at 25 degrees Celsius in 1/4 LSB
+            uint16_t temperatureOffset;
+
+            /// Temperature sensor gain in 0.1 degrees Celsius per LSB (Q8)
+            uint16_t temperatureGain;
+        };
+
+        static_assert(t_calibrationAddress + sizeof(Calibration) <= EEPROM::capacity(), "Calibration values exceed EEMEM capacity!");
+
+        /**
+        @brief Nominal calibration values according to the data sheet
+        VBG = 1.1V. The temperature sensor output is 314mV at 25 degrees Celsius with a slope of about 1.1mV per degree,
+        i.e. 292 LSB against the internal 1.1V reference and 9.77 tenths of a degree per LSB
+        */
+        static constexpr Calibration c_nominalCalibration = {1100, 292 * 4, 2500};
+
+        /**
+        @brief Initialization. Calibration values are loaded from EEMEM
+        @result Flag indicating valid calibration values have been found. Otherwise, nominal values are used
+        */
+        static bool init()
+        {
+            Calibration calibration;
+            EEPROM::read(t_calibrationAddress, &calibration, sizeof(calibration));
+
+            const bool valid = isValid(calibration);
+            s_calibration = valid ? calibration : c_nominalCalibration;
+            return valid;
+        }
+
+        /**
+        @brief Get the calibration values in use
+        @result Calibration values
+        */
+        [[nodiscard]] static const Calibration& getCalibration()
+        {
+            return s_calibration;
+        }
+
+        /**
+        @brief Use the given calibration values and store them in EEMEM
+        @param calibration Calibration values
+        @result Flag indicating the calibration values are plausible and have been stored
+        */
+        static bool setCalibration(const Calibration& calibration)
+        {
+            if (!isValid(calibration))
+            {
+                return false;
+            }
+
+            s_calibration = calibration;
+            EEPROM::write(t_calibrationAddress, &calibration, sizeof(calibration));
+            return true;
+        }
+
+        /**
+        @brief Measure the supply voltage AVCC
+        @result Supply voltage in mV
+        */
+        [[nodiscard]] static uint16_t readSupplyVoltage()
+        {
+            // VBG / AVCC = ADC / 1024 with ADC accumulated in 1/4 LSB
+            const uint16_t bandgap = convert(ADConverter::ReferenceSelection::AVCC, ADConverter::ChannelSelection::VBG);
+            const uint32_t numerator = static_cast<uint32_t>(s_calibration.bandgapVoltage) * (1024 * c_sampleCount);
+            return static_cast<uint16_t>((numerator + bandgap / 2) / bandgap);
+        }
+
+        /**
+        @brief Measure the die temperature
+        @result Temperature in 0.1 degrees Celsius
+        */
+        [[nodiscard]] static int16_t readTemperature()
+        {
+            const uint16_t temperature = convert(ADConverter::ReferenceSelection::INTERNAL, ADConverter::ChannelSelection::ADC8);
+            return toTemperature(temperature);
+        }
+
+        /**
+        @brief Convert a right-aligned 10-bit conversion result against AVCC into a voltage
+        @param value Conversion result
+        @param supplyVoltage Supply voltage in mV as returned by readSupplyVoltage()
+        @result Input voltage in mV
+        */
+        [[nodiscard]] static constexpr uint16_t toMillivolts(const uint16_t value, const uint16_t supplyVoltage)
+        {
+            return static_cast<uint16_t>((static_cast<uint32_t>(value) * supplyVoltage + 512) >> 10);
+        }
+
+        /**
+        @brief Calibrate the bandgap voltage against a reference measurement of the supply voltage and store the result in EEMEM
+        @param supplyVoltage Actual supply voltage in mV
+        @result Flag indicating the calibration has been stored
+        */
+        static bool calibrateSupplyVoltage(const uint16_t supplyVoltage)
+        {
+            const uint16_t bandgap = convert(ADConverter::ReferenceSelection::AVCC, ADConverter::ChannelSelection::VBG);
+
+            Calibration calibration = s_calibration;
+            calibration.bandgapVoltage = static_cast<uint16_t>((static_cast<uint32_t>(supplyVoltage) * bandgap + (512 * c_sampleCount)) / (1024 * c_sampleCount));
+            return setCalibration(calibration);
+        }
+
+        /**
+        @brief Calibrate the temperature sensor offset against a reference measurement and store the result in EEMEM
+        @param temperature Actual die temperature in 0.1 degrees Celsius
+        @result Flag indicating the calibration has been stored
+        @note The gain is kept. The device should be at rest for a while, so the die temperature equals the ambient temperature
+        */
+        static bool calibrateTemperature(const int16_t temperature)
+        {
+            const uint16_t value = convert(ADConverter::ReferenceSelection::INTERNAL, ADConverter::ChannelSelection::ADC8);
+
+            // Conversion result at the given temperature minus the temperature difference to 25 degrees Celsius in 1/4 LSB
+            const int32_t difference = (static_cast<int32_t>(temperature - 250) * (256 * c_sampleCount)) / s_calibration.temperatureGain;
+
+            Calibration calibration = s_calibration;
+            calibration.temperatureOffset = static_cast<uint16_t>(static_cast<int32_t>(value) - difference);
+            return setCalibration(calibration);
+        }
+
+        private:
+
+        // Number of accumulated conversions per measurement
+        static constexpr uint8_t c_sampleCount = 4;
+
+        // Settling time in us after a channel change. Start-up time of the bandgap reference
+        static constexpr uint16_t c_channelSettlingTime = 70;
+
+        // Convert the temperature sensor output in 1/4 LSB into 0.1 degrees Celsius
+        static int16_t toTemperature(const uint16_t value)
+        {
+            const int32_t difference = static_cast<int32_t>(value) - s_calibration.temperatureOffset;
+            return static_cast<int16_t>(250 + ((difference * s_calibration.temperatureGain + (128 * c_sampleCount)) >> 10));
+        }
+
+        // Plausibility check of calibration values. Erased EEMEM reads 0xFFFF
+        static constexpr bool isValid(const Calibration& calibration)
+        {
+            return
+            calibration.bandgapVoltage >= 1000 && calibration.bandgapVoltage <= 1200 &&
+            calibration.temperatureOffset != UINT16_MAX &&
+            calibration.temperatureGain != 0 && calibration.temperatureGain != UINT16_MAX;
+        }
+
+        // Convert the given channel against the given reference voltage. Returns the sum of c_sampleCount conversions
+        static uint16_t convert(const ADConverter::ReferenceSelection referenceSelection, const ADConverter::ChannelSelection channel)
+        {
+            // Wait for a conversion which has been started before
+            ADConverter::wait();
+
+            const ADConverter::ReferenceSelection reference = ADConverter::getReference();
+            const ADConverter::ChannelSelection selected = ADConverter::getChannel();
+            const bool leftAligned = ADConverter::isLeftAligned();
+
+            ADConverter::Reader<uint16_t>::selectAlignment();
+            ADConverter::selectChannel(channel);
+            if (reference != referenceSelection)
+            {
+                ADConverter::selectReference(referenceSelection);
+                _delay_us(t_referenceSettlingTime);
+            }
+            else
+            {
+                _delay_us(c_channelSettlingTime);
+            }
+
+            // The first conversion after a switch is discarded
+            convert();
+
+            uint16_t sum = 0;
+            for (uint8_t sampleIdx = 0; sampleIdx < c_sampleCount; ++sampleIdx)
+            {
+                sum += convert();
+            }
+
+            ADConverter::selectReference(reference);
+            ADConverter::selectChannel(selected);
+            if (leftAligned)
+            {
+                ADConverter::Reader<uint8_t>::selectAlignment();
+            }
+
+            return sum;
+        }
+
+        // Single conversion on the selected channel
+        static uint16_t convert()
+        {
+            ADConverter::startConversion();
+            ADConverter::wait();
+            return ADConverter::Reader<uint16_t>::read();
+        }
+
+        // Calibration values in use
+        inline static Calibration s_calibration = c_nominalCalibration;
+    };
+}
+
+#endif
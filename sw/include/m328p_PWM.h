@@ -0,0 +1,269 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_PWM_H
+#define M328P_PWM_H
+
+#include <stdint.h>
+#include "m328p_Timer1.h"
+#include "m328p_TimerFrequency.h"
+
+namespace m328p
+{
+    /**
+    @brief 8-bit fast PWM on both output compare channels of Timer0 or Timer2
+    TOP is fixed to 0xFF, so the PWM frequency is the timer clock divided by 256. The compare registers are double-buffered by
+    hardware and updated at BOTTOM, so single channel updates are glitch-free.
+    Batch updates of both channels are applied by the overflow interrupt, i.e. right after TOP, so both channels change in the
+    same PWM period. The overflow interrupt is used exclusively by this class.
+    
+    Usage:
+    @code
+    typedef m328p::PWM8Bit<m328p::Timer0> PWM;
+    
+    PWM::init(m328p::Timer0::ClockSelect::PRESCALER_64);
+    sei();
+    PWM::setDuty(64, 192);
+    
+    void m328p::Timer0::handleOVF()
+    {
+        PWM::handleOverflow();
+    }
+    @endcode
+    
+    @tparam Timer Timer driver class (Timer0 or Timer2)
+    @note A duty of 0 still produces a one timer clock wide spike in fast PWM mode
+    */
+    template <typename Timer>
+    class PWM8Bit
+    {
+        public:
+        
+        /**
+        @brief Initialization. Both outputs are configured as non-inverting PWM outputs with duty 0
+        @param clockSelect Timer clock selection
+        */
+        static void init(const typename Timer::ClockSelect clockSelect)
+        {
+            Timer::writeCompareA(0);
+            Timer::writeCompareB(0);
+            Timer::init(
+            Timer::WaveformGenerationMode::PWM_FAST_1,
+            clockSelect,
+            Timer::CompareOutputMode::CLEAR,
+            Timer::CompareOutputMode::CLEAR);
+            
+            Timer::OCA_Pin::setAsOutput();
+            Timer::OCB_Pin::setAsOutput();
+        }
+        
+        /**
+        @brief Get the TOP value
+        @result TOP value, corresponding to a duty of 100%
+        */
+        static constexpr uint8_t getTop()
+        {
+            return 0xFF;
+        }
+        
+        /**
+        @brief Set duty of channel A. The new duty is applied at the next BOTTOM
+        @param duty Duty (0..TOP)
+        */
+        static void setDutyA(const uint8_t duty) __attribute__((always_inline))
+        {
+            Timer::writeCompareA(duty);
+        }
+        
+        /**
+        @brief Set duty of channel B. The new duty is applied at the next BOTTOM
+        @param duty Duty (0..TOP)
+        */
+        static void setDutyB(const uint8_t duty) __attribute__((always_inline))
+        {
+            Timer::writeCompareB(duty);
+        }
+        
+        /**
+        @brief Set duty of both channels. The new duties are applied in the same PWM period
+        @param dutyA Duty of channel A (0..TOP)
+        @param dutyB Duty of channel B (0..TOP)
+        */
+        static void setDuty(const uint8_t dutyA, const uint8_t dutyB)
+        {
+            // The overflow interrupt is disabled while the shadow values are modified, so no atomic section is required
+            Timer::disableOverflowInterrupt();
+            s_dutyA = dutyA;
+            s_dutyB = dutyB;
+            
+            // Discard a stale overflow, so the update is applied right after the next TOP
+            Timer::clearOverflowFlag();
+            Timer::enableOverflowInterrupt();
+        }
+        
+        /**
+        @brief Timer overflow handler
+        @note This method has to be called from the overflow interrupt handler of the timer
+        */
+        static void handleOverflow() __attribute__((always_inline))
+        {
+            Timer::writeCompareA(s_dutyA);
+            Timer::writeCompareB(s_dutyB);
+            Timer::disableOverflowInterrupt();
+        }
+        
+        private:
+        
+        // Shadow values for batch update
+        inline static uint8_t s_dutyA = 0;
+        inline static uint8_t s_dutyB = 0;
+    };
+    
+    /**
+    @brief 16-bit PWM on both output compare channels of Timer1 using ICR1 as TOP
+    Timer1 runs in fast PWM mode with TOP = ICR1, so any frequency can be generated at the highest resolution possible.
+    Clock selection and TOP are solved at compile time from the target frequency, see TimerFrequency.
+    The compare registers are double-buffered by hardware and updated at BOTTOM, so single channel updates are glitch-free.
+    Batch updates of both channels are applied by the overflow interrupt, i.e. right after TOP, so both channels change in the
+    same PWM period. The overflow interrupt is used exclusively by this class.
+    
+    Usage:
+    @code
+    typedef m328p::PWM16Bit<F_CPU, 20000> PWM; // 20 kHz, TOP = 799
+    
+    PWM::init();
+    sei();
+    PWM::setDuty(PWM::getTop() / 4, PWM::getTop() / 2);
+    
+    void m328p::Timer1::handleOVF()
+    {
+        PWM::handleOverflow();
+    }
+    @endcode
+    
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam t_frequency PWM frequency in Hz
+    @tparam t_tolerance Maximum relative frequency error in ppm. Default is 1%
+    @note A duty of 0 still produces a one timer clock wide spike in fast PWM mode
+    */
+    template <uint32_t t_cpuClock, uint32_t t_frequency, uint32_t t_tolerance = 10000>
+    class PWM16Bit
+    {
+        public:
+        
+        /**
+        @brief Initialization. Both outputs are configured as non-inverting PWM outputs with duty 0
+        */
+        static void init()
+        {
+            // ICR1 can only be written if it is used as TOP, so the timer is stopped in the target mode while TOP is not yet valid
+            Timer1::init(
+            Timer1::WaveformGenerationMode::PWM_FAST_1,
+            Timer1::ClockSelect::NONE,
+            Timer1::CompareOutputMode::DISCONNECTED,
+            Timer1::CompareOutputMode::DISCONNECTED);
+            Timer1::writeInputCapture(getTop());
+            Timer1::writeCompareA(0);
+            Timer1::writeCompareB(0);
+            Timer1::writeCounter(0);
+            
+            Timer1::init(
+            Timer1::WaveformGenerationMode::PWM_FAST_1,
+            Frequency::getClockSelect(),
+            Timer1::CompareOutputMode::CLEAR,
+            Timer1::CompareOutputMode::CLEAR);
+            
+            Timer1::OCA_Pin::setAsOutput();
+            Timer1::OCB_Pin::setAsOutput();
+        }
+        
+        /**
+        @brief Get the TOP value
+        @result TOP value, corresponding to a duty of 100%
+        */
+        static constexpr uint16_t getTop()
+        {
+            return Frequency::getTop();
+        }
+        
+        /**
+        @brief Get the achieved PWM frequency
+        @result PWM frequency in Hz
+        */
+        static constexpr uint32_t getFrequency()
+        {
+            return Frequency::getFrequency();
+        }
+        
+        /**
+        @brief Set duty of channel A. The new duty is applied at the next BOTTOM
+        @param duty Duty (0..TOP)
+        */
+        static void setDutyA(const uint16_t duty) __attribute__((always_inline))
+        {
+            Timer1::writeCompareA<Timer1::Access::GUARDED>(duty);
+        }
+        
+        /**
+        @brief Set duty of channel B. The new duty is applied at the next BOTTOM
+        @param duty Duty (0..TOP)
+        */
+        static void setDutyB(const uint16_t duty) __attribute__((always_inline))
+        {
+            Timer1::writeCompareB<Timer1::Access::GUARDED>(duty);
+        }
+        
+        /**
+        @brief Set duty of both channels. The new duties are applied in the same PWM period
+        @param dutyA Duty of channel A (0..TOP)
+        @param dutyB Duty of channel B (0..TOP)
+        */
+        static void setDuty(const uint16_t dutyA, const uint16_t dutyB)
+        {
+            // The overflow interrupt is disabled while the shadow values are modified, so no atomic section is required
+            Timer1::disableOverflowInterrupt();
+            s_dutyA = dutyA;
+            s_dutyB = dutyB;
+            
+            // Discard a stale overflow, so the update is applied right after the next TOP
+            Timer1::clearOverflowFlag();
+            Timer1::enableOverflowInterrupt();
+        }
+        
+        /**
+        @brief Timer1 overflow handler
+        @note This method has to be called from Timer1::handleOVF()
+        */
+        static void handleOverflow() __attribute__((always_inline))
+        {
+            Timer1::writeCompareA(s_dutyA);
+            Timer1::writeCompareB(s_dutyB);
+            Timer1::disableOverflowInterrupt();
+        }
+        
+        private:
+        
+        // Compile-time clock selection and TOP value
+        typedef TimerFrequency<Timer1, t_cpuClock, t_frequency, t_tolerance> Frequency;
+        
+        // Shadow values for batch update
+        inline static uint16_t s_dutyA = 0;
+        inline static uint16_t s_dutyB = 0;
+    };
+}
+
+#endif
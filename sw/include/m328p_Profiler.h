@@ -0,0 +1,286 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_PROFILER_H
+#define M328P_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Atomic.h"
+#include "m328p_USART0.h"
+
+namespace m328p
+{
+    /**
+    @brief Cycle-accurate profiler for code regions
+    A SystemClock running at PRESCALER_1 is used as a 32-bit cycle counter, i.e. TCNT1 is extended by the Timer1 overflow
+    interrupt. For each region, the number of executions as well as the minimum, maximum and total number of CPU cycles are
+    accumulated in a static table. Regions are measured using ScopedProfile objects and may be located in interrupt handlers.
+    The measurement overhead is determined by init() and subtracted from every measurement.
+
+    Usage:
+    @code
+    typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_1> Clock;
+    typedef m328p::Profiler<Clock, 2> Profiler;
+
+    enum Region : uint8_t {MAIN_LOOP, ADC_ISR};
+
+    int main()
+    {
+        Clock::init();
+        sei();
+        Profiler::init();
+
+        while (true)
+        {
+            m328p::ScopedProfile<Profiler, MAIN_LOOP> profile;
+            ...
+            if (dumpRequested)
+            {
+                Profiler::dump();
+            }
+        }
+    }
+
+    // Timer1 overflow interrupt handler
+    void m328p::Timer1::handleOVF()
+    {
+        Clock::handleOverflow();
+    }
+    @endcode
+
+    @tparam Clock SystemClock running at PRESCALER_1
+    @tparam t_regionCount Number of profiled regions
+    @note The USART has to be initialized by the user before calling dump()
+    */
+    template <typename Clock, uint8_t t_regionCount>
+    class Profiler
+    {
+        static_assert(Clock::getPrescaler() == 1, "Profiler requires a system clock running at PRESCALER_1!");
+        static_assert(t_regionCount > 0, "Profiler requires at least one region!");
+
+        public:
+
+        /// Duration in CPU cycles
+        typedef uint32_t Cycles;
+
+        /// Statistics of one profiled region
+        struct Region
+        {
+            uint32_t count; // Number of executions
+            Cycles min; // Minimum number of cycles per execution
+            Cycles max; // Maximum number of cycles per execution
+            Cycles total; // Total number of cycles. Saturates at UINT32_MAX (about 268 s at 16 MHz)
+        };
+
+        /**
+        @brief Initialization. Clears the statistics of all regions and measures the overhead of an empty region
+        @note The system clock has to be initialized and interrupts have to be enabled before calling this method
+        */
+        static void init()
+        {
+            s_overhead = 0;
+            Cycles overhead = UINT32_MAX;
+            for (uint8_t cnt = 0; cnt < 4; ++cnt)
+            {
+                const Cycles start = Clock::now();
+                const Cycles cycles = Clock::now() - start;
+                if (cycles < overhead)
+                {
+                    overhead = cycles;
+                }
+            }
+            s_overhead = overhead;
+
+            reset();
+        }
+
+        /**
+        @brief Clear the statistics of all regions
+        */
+        static void reset()
+        {
+            Atomic atomic;
+            for (Region& region : s_regions)
+            {
+                region = Region{0, UINT32_MAX, 0, 0};
+            }
+        }
+
+        /**
+        @brief Get the number of profiled regions
+        @result Number of regions
+        */
+        static constexpr uint8_t getRegionCount()
+        {
+            return t_regionCount;
+        }
+
+        /**
+        @brief Get the measurement overhead subtracted from every measurement
+        @result Overhead in CPU cycles
+        */
+        [[nodiscard]] static Cycles getOverhead()
+        {
+            return s_overhead;
+        }
+
+        /**
+        @brief Get a consistent copy of the statistics of one region
+        @param regionIdx Region index
+        @result Statistics of the region. If the region has not been executed, count is zero
+        */
+        [[nodiscard]] static Region getRegion(const uint8_t regionIdx)
+        {
+            Atomic atomic;
+            return s_regions[regionIdx];
+        }
+
+        /**
+        @brief Get a time stamp marking the entry of a region
+        @result Time stamp in CPU cycles
+        */
+        [[nodiscard]] static Cycles begin() __attribute__((always_inline))
+        {
+            return Clock::now();
+        }
+
+        /**
+        @brief Record the execution of a region
+        @param regionIdx Region index
+        @param start Time stamp taken by begin() on entry of the region
+        */
+        static void end(const uint8_t regionIdx, const Cycles start)
+        {
+            Cycles cycles = Clock::now() - start;
+            cycles = (cycles > s_overhead) ? cycles - s_overhead : 0;
+
+            // Regions may be nested and located in interrupt handlers
+            Atomic atomic;
+            Region& region = s_regions[regionIdx];
+            ++region.count;
+            if (cycles < region.min)
+            {
+                region.min = cycles;
+            }
+            if (cycles > region.max)
+            {
+                region.max = cycles;
+            }
+            region.total = (UINT32_MAX - region.total > cycles) ? region.total + cycles : UINT32_MAX;
+        }
+
+        /**
+        @brief Write the statistics of all regions to USART0
+        One line per executed region in the format "<idx> <count> <min> <max> <total>", followed by CR LF
+        @note This method blocks until all characters have been transmitted. Do not call from an interrupt handler
+        */
+        static void dump()
+        {
+            for (uint8_t regionIdx = 0; regionIdx < t_regionCount; ++regionIdx)
+            {
+                const Region region = getRegion(regionIdx);
+                if (region.count == 0)
+                {
+                    continue;
+                }
+
+                putDecimal(regionIdx);
+                put(' ');
+                putDecimal(region.count);
+                put(' ');
+                putDecimal(region.min);
+                put(' ');
+                putDecimal(region.max);
+                put(' ');
+                putDecimal(region.total);
+                put('\r');
+                put('\n');
+            }
+        }
+
+        private:
+
+        // Transmit one character, waiting for the transmit buffer
+        static void put(const char character)
+        {
+            while (!USART0::isReadyToTransmit());
+            USART0::put(character);
+        }
+
+        // Transmit an unsigned number in decimal representation
+        static void putDecimal(uint32_t value)
+        {
+            char digits[10];
+            uint8_t digitCount = 0;
+            do
+            {
+                digits[digitCount++] = '0' + value % 10;
+                value /= 10;
+            }
+            while (value != 0);
+
+            while (digitCount != 0)
+            {
+                put(digits[--digitCount]);
+            }
+        }
+
+        // Statistics of all regions
+        inline static Region s_regions[t_regionCount];
+
+        // Measurement overhead of an empty region
+        inline static Cycles s_overhead = 0;
+    };
+
+    /**
+    @brief RAII profiling region. The region extends from construction to destruction of the object
+    @tparam Profiler Profiler instance
+    @tparam t_regionIdx Region index
+    */
+    template <typename Profiler, uint8_t t_regionIdx>
+    class ScopedProfile
+    {
+        static_assert(t_regionIdx < Profiler::getRegionCount(), "Region index out of range!");
+
+        public:
+
+        /**
+        @brief Constructor. Marks the entry of the region
+        */
+        ScopedProfile() : m_start(Profiler::begin())
+        {}
+
+        /**
+        @brief Destructor. Marks the exit of the region
+        */
+        ~ScopedProfile()
+        {
+            Profiler::end(t_regionIdx, m_start);
+        }
+
+        ScopedProfile(const ScopedProfile&) = delete;
+        ScopedProfile& operator=(const ScopedProfile&) = delete;
+
+        private:
+
+        // Time stamp on entry of the region
+        const typename Profiler::Cycles m_start;
+    };
+}
+
+#endif
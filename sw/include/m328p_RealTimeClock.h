@@ -0,0 +1,290 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_REALTIMECLOCK_H
+#define M328P_REALTIMECLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/sleep.h>
+#include "m328p_Timer2.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Real-time clock based on Timer2 in asynchronous mode
+    Timer2 is clocked from a 32.768 kHz watch crystal on TOSC1/TOSC2 with a prescaler of 128, so it overflows once per second.
+    The overflow interrupt increments a 32-bit epoch counter (seconds since 2000-01-01 00:00:00), while TCNT2 provides
+    sub-second ticks of 1/256 s. Timer2 keeps running in power-save mode and wakes the device up every second.
+    
+    Usage:
+    @code
+    int main()
+    {
+        m328p::RealTimeClock::init();
+        sei();
+        
+        while (1)
+        {
+            ... // Sample sensors
+            m328p::RealTimeClock::sleep();
+        }
+    }
+    
+    void m328p::Timer2::handleOVF()
+    {
+        m328p::RealTimeClock::handleOverflow();
+    }
+    @endcode
+    */
+    class RealTimeClock
+    {
+        public:
+        
+        /// Seconds since 2000-01-01 00:00:00
+        typedef uint32_t Seconds;
+        
+        /// Time stamp with sub-second resolution
+        struct Time
+        {
+            /// Seconds since 2000-01-01 00:00:00
+            Seconds seconds;
+            
+            /// Fraction of the current second in 1/256 s
+            uint8_t fraction;
+        };
+        
+        /// Calendar date and time
+        struct DateTime
+        {
+            /// Year (2000..2136)
+            uint16_t year;
+            
+            /// Month (1..12)
+            uint8_t month;
+            
+            /// Day of month (1..31)
+            uint8_t day;
+            
+            /// Hour (0..23)
+            uint8_t hour;
+            
+            /// Minute (0..59)
+            uint8_t minute;
+            
+            /// Second (0..59)
+            uint8_t second;
+            
+            /// Day of week (0 = Monday .. 6 = Sunday)
+            uint8_t weekday;
+        };
+        
+        /**
+        @brief Initialization
+        @param seconds Initial time in seconds since 2000-01-01 00:00:00
+        @note The crystal oscillator may need up to one second to stabilize after power-up
+        */
+        static void init(const Seconds seconds = 0)
+        {
+            Timer2::enableAsynchronousMode();
+            Timer2::init(
+            Timer2::WaveformGenerationMode::NORMAL,
+            Timer2::ClockSelect::PRESCALER_128,
+            Timer2::CompareOutputMode::DISCONNECTED,
+            Timer2::CompareOutputMode::DISCONNECTED);
+            Timer2::writeCounter(0);
+            Timer2::waitForUpdate();
+            Timer2::clearInterruptFlags();
+            
+            s_seconds = seconds;
+            Timer2::enableOverflowInterrupt();
+        }
+        
+        /**
+        @brief Timer2 overflow handler
+        @note This method has to be called from Timer2::handleOVF()
+        */
+        static void handleOverflow() __attribute__((always_inline))
+        {
+            s_seconds = s_seconds + 1;
+        }
+        
+        /**
+        @brief Get current time in seconds
+        @result Seconds since 2000-01-01 00:00:00
+        */
+        [[nodiscard]] static Seconds getSeconds()
+        {
+            Seconds seconds;
+            
+            // Re-read instead of disabling interrupts
+            do
+            {
+                seconds = s_seconds;
+            }
+            while (seconds != s_seconds);
+            
+            return seconds;
+        }
+        
+        /**
+        @brief Get current time with sub-second resolution
+        @result Current time
+        @note After a wake-up from power-save mode, call Timer2::synchronize() before, otherwise TCNT2 may read a stale value
+        */
+        [[nodiscard]] static Time now()
+        {
+            Seconds seconds;
+            uint8_t fraction;
+            bool overflowPending;
+            
+            do
+            {
+                seconds = s_seconds;
+                fraction = Timer2::readCounter();
+                overflowPending = Timer2::isOverflowPending();
+            }
+            while (seconds != s_seconds);
+            
+            // The overflow is only accounted for if the counter has been read after wrapping around
+            if (overflowPending && (fraction < 0x80))
+            {
+                ++seconds;
+            }
+            
+            return Time{seconds, fraction};
+        }
+        
+        /**
+        @brief Set current time
+        @param seconds Seconds since 2000-01-01 00:00:00
+        @note The sub-second ticks are not reset
+        */
+        static void setSeconds(const Seconds seconds)
+        {
+            Atomic atomic;
+            s_seconds = seconds;
+        }
+        
+        /**
+        @brief Enter power-save mode until the next interrupt
+        Before entering power-save mode, the asynchronous timer is synchronized. Otherwise, re-entering power-save mode within the
+        same TOSC1 cycle after a wake-up by Timer2 would result in an immediate wake-up without further interrupt.
+        @note Global interrupts are enabled by this method
+        */
+        static void sleep()
+        {
+            Timer2::synchronize();
+            set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        
+        /**
+        @brief Convert seconds since 2000-01-01 00:00:00 to calendar date and time
+        @param seconds Seconds since 2000-01-01 00:00:00
+        @result Calendar date and time
+        */
+        [[nodiscard]] static DateTime toDateTime(const Seconds seconds)
+        {
+            DateTime dateTime;
+            
+            uint16_t days = seconds / 86400UL;
+            uint32_t secondOfDay = seconds % 86400UL;
+            dateTime.hour = secondOfDay / 3600;
+            secondOfDay %= 3600;
+            dateTime.minute = secondOfDay / 60;
+            dateTime.second = secondOfDay % 60;
+            
+            // 2000-01-01 was a Saturday
+            dateTime.weekday = (days + 5) % 7;
+            
+            dateTime.year = 2000;
+            while (days >= getDaysInYear(dateTime.year))
+            {
+                days -= getDaysInYear(dateTime.year);
+                ++dateTime.year;
+            }
+            
+            dateTime.month = 1;
+            while (days >= getDaysInMonth(dateTime.year, dateTime.month))
+            {
+                days -= getDaysInMonth(dateTime.year, dateTime.month);
+                ++dateTime.month;
+            }
+            
+            dateTime.day = days + 1;
+            return dateTime;
+        }
+        
+        /**
+        @brief Convert calendar date and time to seconds since 2000-01-01 00:00:00
+        @param dateTime Calendar date and time. The day of week is ignored
+        @result Seconds since 2000-01-01 00:00:00
+        */
+        [[nodiscard]] static Seconds toSeconds(const DateTime & dateTime)
+        {
+            uint16_t days = dateTime.day - 1;
+            
+            for (uint16_t year = 2000; year < dateTime.year; ++year)
+            {
+                days += getDaysInYear(year);
+            }
+            
+            for (uint8_t month = 1; month < dateTime.month; ++month)
+            {
+                days += getDaysInMonth(dateTime.year, month);
+            }
+            
+            return days * 86400UL + dateTime.hour * 3600UL + dateTime.minute * 60U + dateTime.second;
+        }
+        
+        private:
+        
+        // Gregorian leap year rule
+        static constexpr bool isLeapYear(const uint16_t year)
+        {
+            return ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+        }
+        
+        // Number of days in a year
+        static constexpr uint16_t getDaysInYear(const uint16_t year)
+        {
+            return isLeapYear(year) ? 366 : 365;
+        }
+        
+        // Number of days in a month (1..12)
+        static constexpr uint8_t getDaysInMonth(const uint16_t year, const uint8_t month)
+        {
+            if (month == 2)
+            {
+                return isLeapYear(year) ? 29 : 28;
+            }
+            
+            // Months with 30 days: April, June, September, November
+            return (month == 4 || month == 6 || month == 9 || month == 11) ? 30 : 31;
+        }
+        
+        // Seconds since 2000-01-01 00:00:00
+        inline static volatile Seconds s_seconds = 0;
+    };
+}
+
+#endif
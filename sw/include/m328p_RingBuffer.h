@@ -0,0 +1,136 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_RINGBUFFER_H
+#define M328P_RINGBUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+namespace m328p
+{
+    /**
+    @brief Lock-free single-producer/single-consumer ring buffer
+    The producer (typically an interrupt handler) only modifies the write index and the consumer only modifies the read index,
+    so neither side has to disable interrupts. The indices are single bytes, hence they are read and written atomically.
+    @tparam Elem Element type
+    @tparam t_size Number of elements (power of two, 2..128). One element is kept free to distinguish a full from an empty buffer
+    */
+    template <typename Elem, uint8_t t_size>
+    class RingBuffer
+    {
+        static_assert(t_size >= 2 && t_size <= 128 && (t_size & (t_size - 1)) == 0, "Invalid size: Size must be a power of two in 2..128!");
+        
+        public:
+        
+        /**
+        @brief Append an element (producer side)
+        @param elem Element to be appended
+        @result Flag indicating the element has been appended. False if the buffer is full
+        */
+        bool push(const Elem & elem)
+        {
+            const uint8_t head = m_head;
+            const uint8_t next = (head + 1) & c_mask;
+            if (next == m_tail)
+            {
+                return false;
+            }
+            
+            m_data[head] = elem;
+            
+            // Publish the element only after it has been written completely
+            __asm__ __volatile__ ("" ::: "memory");
+            m_head = next;
+            return true;
+        }
+        
+        /**
+        @brief Remove the oldest element (consumer side)
+        @param elem Removed element
+        @result Flag indicating an element has been removed. False if the buffer is empty
+        */
+        bool pop(Elem & elem)
+        {
+            const uint8_t tail = m_tail;
+            if (tail == m_head)
+            {
+                return false;
+            }
+            
+            // Read the element only after the write index has been checked
+            __asm__ __volatile__ ("" ::: "memory");
+            elem = m_data[tail];
+            
+            // Release the element only after it has been read completely
+            __asm__ __volatile__ ("" ::: "memory");
+            m_tail = (tail + 1) & c_mask;
+            return true;
+        }
+        
+        /**
+        @brief Discard all elements (consumer side)
+        */
+        void clear()
+        {
+            m_tail = m_head;
+        }
+        
+        /**
+        @brief Check if the buffer is empty
+        @result Flag indicating the buffer is empty
+        */
+        [[nodiscard]] bool isEmpty() const
+        {
+            return m_head == m_tail;
+        }
+        
+        /**
+        @brief Get the number of elements in the buffer
+        @result Number of elements
+        */
+        [[nodiscard]] uint8_t getSize() const
+        {
+            return (m_head - m_tail) & c_mask;
+        }
+        
+        /**
+        @brief Get the maximum number of elements in the buffer
+        @result Maximum number of elements
+        */
+        static constexpr uint8_t getCapacity()
+        {
+            return t_size - 1;
+        }
+        
+        private:
+        
+        // Index mask
+        static constexpr uint8_t c_mask = t_size - 1;
+        
+        // Element storage
+        Elem m_data[t_size];
+        
+        // Write index, modified by the producer only
+        volatile uint8_t m_head = 0;
+        
+        // Read index, modified by the consumer only
+        volatile uint8_t m_tail = 0;
+    };
+}
+
+#endif
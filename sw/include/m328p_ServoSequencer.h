@@ -0,0 +1,378 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_SERVOSEQUENCER_H
+#define M328P_SERVOSEQUENCER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Timer1.h"
+#include "m328p_GPIO.h"
+
+namespace m328p
+{
+    /**
+    @brief RC servo pulse sequencer driving up to 16 servos on arbitrary GP I/O pins using the Timer1 compare match A interrupt
+    Timer1 runs in CTC mode with ICR1 as TOP, so one timer period is one 20 ms servo frame. All pulses start at the beginning
+    of a frame and end in ascending order of their pulse width. The end times are sorted and merged into a schedule by update()
+    in the main loop, so the interrupt handler only toggles the pins of the current schedule entry via the PINx registers and
+    loads the time of the next entry into OCR1A. Pulse ends closer than getMinimumGap() are merged into a single entry.
+
+    Pulse widths set by setPulseWidth() are committed by update() and take effect at the beginning of the next frame. The
+    schedule is double-buffered, so a frame is never generated from a partially updated schedule.
+
+    Usage:
+    @code
+    typedef m328p::ServoSequencer<F_CPU,
+    m328p::GPIOPin<m328p::Port::D, 2>,
+    m328p::GPIOPin<m328p::Port::D, 4>,
+    m328p::GPIOPin<m328p::Port::C, 0>> Servos;
+
+    int main()
+    {
+        Servos::init();
+        sei();
+
+        while (true)
+        {
+            Servos::setPulseWidth(0, 1200);
+            Servos::setPulseWidth(2, 1800);
+            Servos::update();
+            ...
+        }
+    }
+
+    // Timer1 compare match A interrupt handler
+    void m328p::Timer1::handleCOMPA()
+    {
+        Servos::handleCompareMatch();
+    }
+    @endcode
+
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam Pins GPIOPin types of the servo outputs. The servo index is the position in this list
+    @note Timer1 is used exclusively by this class. The servo pins must not be written by the application
+    */
+    template <uint32_t t_cpuClock, typename... Pins>
+    class ServoSequencer
+    {
+        static constexpr uint8_t c_servoCount = sizeof...(Pins);
+        static_assert(c_servoCount > 0 && c_servoCount <= 16, "ServoSequencer supports 1 to 16 servos!");
+
+        public:
+
+        /// Frame period in microseconds
+        static constexpr uint16_t c_framePeriod = 20000;
+
+        /// Minimum pulse width in microseconds
+        static constexpr uint16_t c_minimumPulseWidth = 500;
+
+        /// Maximum pulse width in microseconds
+        static constexpr uint16_t c_maximumPulseWidth = 2500;
+
+        /// Default pulse width (center position) in microseconds
+        static constexpr uint16_t c_defaultPulseWidth = 1500;
+
+        /**
+        @brief Initialization. All servos are set to the center position and Timer1 is started
+        */
+        static void init()
+        {
+            (Pins::low(), ...);
+            (Pins::setAsOutput(), ...);
+
+            for (uint8_t servoIdx = 0; servoIdx < c_servoCount; ++servoIdx)
+            {
+                s_pulseWidths[servoIdx] = toTicks(c_defaultPulseWidth);
+            }
+
+            s_active = 0;
+            s_pending = false;
+            s_entryIdx = 0;
+            update();
+
+            // ICR1 can only be written if it is used as TOP. The first compare match at BOTTOM starts the first frame
+            Timer1::init(
+            Timer1::WaveformGenerationMode::CTC_2,
+            Timer1::ClockSelect::NONE,
+            Timer1::CompareOutputMode::DISCONNECTED,
+            Timer1::CompareOutputMode::DISCONNECTED);
+
+            Timer1::writeInputCapture<Timer1::Access::GUARDED>(c_top);
+            Timer1::writeCompareA<Timer1::Access::GUARDED>(0);
+            Timer1::writeCounter<Timer1::Access::GUARDED>(c_top);
+            Timer1::clearCompareMatchAFlag();
+            Timer1::enableCompareMatchAInterrupt();
+
+            Timer1::init(
+            Timer1::WaveformGenerationMode::CTC_2,
+            c_clockSelect,
+            Timer1::CompareOutputMode::DISCONNECTED,
+            Timer1::CompareOutputMode::DISCONNECTED);
+        }
+
+        /**
+        @brief Get the number of servos
+        @result Number of servos
+        */
+        static constexpr uint8_t getServoCount()
+        {
+            return c_servoCount;
+        }
+
+        /**
+        @brief Get the resolution of pulse end times. Pulses ending closer than this are merged
+        @result Minimum gap between two schedule entries in microseconds (rounded up)
+        */
+        static constexpr uint16_t getMinimumGap()
+        {
+            return (static_cast<uint32_t>(c_minimumGap) * c_prescaler * 1000000UL + t_cpuClock - 1) / t_cpuClock;
+        }
+
+        /**
+        @brief Set the pulse width of a servo. The new pulse width takes effect after the next call of update()
+        @param servoIdx Servo index
+        @param pulseWidth Pulse width in microseconds. The pulse width is limited to the range of c_minimumPulseWidth and
+        c_maximumPulseWidth. A pulse width of zero disables the pulses for this servo
+        */
+        static void setPulseWidth(const uint8_t servoIdx, uint16_t pulseWidth)
+        {
+            if (pulseWidth != 0)
+            {
+                if (pulseWidth < c_minimumPulseWidth)
+                {
+                    pulseWidth = c_minimumPulseWidth;
+                }
+                else if (pulseWidth > c_maximumPulseWidth)
+                {
+                    pulseWidth = c_maximumPulseWidth;
+                }
+            }
+
+            s_pulseWidths[servoIdx] = toTicks(pulseWidth);
+        }
+
+        /**
+        @brief Commit all pulse widths. The new schedule is used from the beginning of the next frame on
+        If update() is called again before the next frame begins, the previously committed schedule is replaced
+        @note This method must not be called from an interrupt handler
+        */
+        static void update()
+        {
+            // Withdraw a committed schedule which has not been activated yet. The inactive buffer can then be rebuilt safely
+            s_pending = false;
+            Schedule& schedule = s_schedules[s_active ^ 1];
+
+            // Sort servo indices by ascending pulse width (insertion sort)
+            uint8_t order[c_servoCount];
+            uint8_t count = 0;
+            for (uint8_t servoIdx = 0; servoIdx < c_servoCount; ++servoIdx)
+            {
+                const uint16_t pulseWidth = s_pulseWidths[servoIdx];
+                if (pulseWidth == 0)
+                {
+                    continue;
+                }
+
+                uint8_t pos = count++;
+                while (pos > 0 && s_pulseWidths[order[pos - 1]] > pulseWidth)
+                {
+                    order[pos] = order[pos - 1];
+                    --pos;
+                }
+                order[pos] = servoIdx;
+            }
+
+            // Build schedule. Pulse ends closer than the minimum gap are merged into the preceding entry
+            for (uint8_t& mask : schedule.startMasks)
+            {
+                mask = 0;
+            }
+
+            uint8_t entryCount = 0;
+            for (uint8_t pos = 0; pos < count; ++pos)
+            {
+                const uint8_t servoIdx = order[pos];
+                const uint16_t time = s_pulseWidths[servoIdx];
+
+                if (entryCount == 0 || time - schedule.entries[entryCount - 1].time >= c_minimumGap)
+                {
+                    Entry& entry = schedule.entries[entryCount++];
+                    entry.time = time;
+                    for (uint8_t& mask : entry.masks)
+                    {
+                        mask = 0;
+                    }
+                }
+
+                schedule.entries[entryCount - 1].masks[c_portIdx[servoIdx]] |= c_pinMask[servoIdx];
+                schedule.startMasks[c_portIdx[servoIdx]] |= c_pinMask[servoIdx];
+            }
+            schedule.entryCount = entryCount;
+
+            // Make sure the schedule is written completely before it is committed
+            __asm__ __volatile__ ("" ::: "memory");
+            s_pending = true;
+        }
+
+        /**
+        @brief Timer1 compare match A handler
+        @note This method has to be called from Timer1::handleCOMPA()
+        */
+        static void handleCompareMatch() __attribute__((always_inline))
+        {
+            if (s_entryIdx == 0)
+            {
+                // Beginning of frame
+                if (s_pending)
+                {
+                    s_active = s_active ^ 1;
+                    s_pending = false;
+                }
+
+                const Schedule& schedule = s_schedules[s_active];
+                togglePins(schedule.startMasks);
+
+                if (schedule.entryCount != 0)
+                {
+                    Timer1::writeCompareA(schedule.entries[0].time);
+                    s_entryIdx = 1;
+                }
+            }
+            else
+            {
+                // End of one or more pulses
+                const Schedule& schedule = s_schedules[s_active];
+                const uint8_t entryIdx = s_entryIdx;
+                togglePins(schedule.entries[entryIdx - 1].masks);
+
+                if (entryIdx < schedule.entryCount)
+                {
+                    Timer1::writeCompareA(schedule.entries[entryIdx].time);
+                    s_entryIdx = entryIdx + 1;
+                }
+                else
+                {
+                    Timer1::writeCompareA(0);
+                    s_entryIdx = 0;
+                }
+            }
+        }
+
+        private:
+
+        // Timer1 runs at clk/8, i.e. at 0.5 us resolution for a 16 MHz CPU clock
+        static constexpr Timer1::ClockSelect c_clockSelect = Timer1::ClockSelect::PRESCALER_8;
+        static constexpr uint32_t c_prescaler = Timer1::getPrescaler(c_clockSelect);
+
+        // Greatest common divisor
+        static constexpr uint32_t gcd(const uint32_t a, const uint32_t b)
+        {
+            return (b == 0) ? a : gcd(b, a % b);
+        }
+
+        // Timer ticks per microsecond as reduced fraction, so the conversion of pulse widths does not overflow
+        static constexpr uint32_t c_gcd = gcd(t_cpuClock / c_prescaler, 1000000UL);
+        static constexpr uint32_t c_ticksPerMicrosecondNum = t_cpuClock / c_prescaler / c_gcd;
+        static constexpr uint32_t c_ticksPerMicrosecondDen = 1000000UL / c_gcd;
+        static_assert(c_ticksPerMicrosecondNum <= UINT32_MAX / c_maximumPulseWidth, "Conversion factor out of range for this CPU clock!");
+
+        // Convert microseconds to timer ticks
+        static constexpr uint16_t toTicks(const uint16_t microseconds)
+        {
+            return (static_cast<uint32_t>(microseconds) * c_ticksPerMicrosecondNum + c_ticksPerMicrosecondDen / 2) / c_ticksPerMicrosecondDen;
+        }
+
+        // TOP value for a 20 ms frame
+        static constexpr uint32_t c_frameTicks = static_cast<uint64_t>(c_framePeriod) * (t_cpuClock / c_prescaler) / 1000000UL;
+        static_assert(c_frameTicks <= 0x10000UL, "Servo frame exceeds Timer1 range for this CPU clock!");
+        static constexpr uint16_t c_top = c_frameTicks - 1;
+
+        // Minimum distance of two schedule entries in timer ticks. Covers interrupt latency and execution of the handler
+        static constexpr uint16_t c_handlerCycles = 128;
+        static constexpr uint16_t c_minimumGap = (c_handlerCycles + c_prescaler - 1) / c_prescaler + 1;
+
+        // Number of GP I/O ports
+        static constexpr uint8_t c_portCount = 3;
+
+        // Port index and pin mask of each servo
+        static constexpr uint8_t c_portIdx[c_servoCount] = {static_cast<uint8_t>(Pins::getPort())...};
+        static constexpr uint8_t c_pinMask[c_servoCount] = {static_cast<uint8_t>(1 << Pins::getPinIdx())...};
+
+        // Check if any servo is connected to a given port
+        static constexpr bool usesPort(const Port port)
+        {
+            return ((Pins::getPort() == port) || ...);
+        }
+
+        // Access to the pin input registers. Writing a logical one to PINxn toggles PORTxn
+        template <Port t_port>
+        struct PortRegisters : GPIORegisterAccess<t_port>
+        {
+            typedef typename GPIORegisterAccess<t_port>::PIN PIN;
+        };
+
+        // Toggle the pins given by one mask per port
+        static void togglePins(const uint8_t (&masks)[c_portCount]) __attribute__((always_inline))
+        {
+            if constexpr (usesPort(Port::B))
+            {
+                PortRegisters<Port::B>::PIN::write(masks[static_cast<uint8_t>(Port::B)]);
+            }
+            if constexpr (usesPort(Port::C))
+            {
+                PortRegisters<Port::C>::PIN::write(masks[static_cast<uint8_t>(Port::C)]);
+            }
+            if constexpr (usesPort(Port::D))
+            {
+                PortRegisters<Port::D>::PIN::write(masks[static_cast<uint8_t>(Port::D)]);
+            }
+        }
+
+        // Schedule entry: Pins to be toggled at a given counter value
+        struct Entry
+        {
+            uint16_t time;
+            uint8_t masks[c_portCount];
+        };
+
+        // Schedule of one frame
+        struct Schedule
+        {
+            uint8_t startMasks[c_portCount];
+            uint8_t entryCount;
+            Entry entries[c_servoCount];
+        };
+
+        // Double-buffered schedule
+        inline static Schedule s_schedules[2];
+
+        // Index of the schedule used by the interrupt handler
+        inline static volatile uint8_t s_active = 0;
+
+        // Flag indicating the inactive schedule has been committed
+        inline static volatile bool s_pending = false;
+
+        // Index of the next schedule entry plus one. Zero if the next compare match is the beginning of a frame
+        inline static uint8_t s_entryIdx = 0;
+
+        // Pulse widths in timer ticks. Zero if disabled
+        inline static uint16_t s_pulseWidths[c_servoCount];
+    };
+}
+
+#endif
@@ -0,0 +1,281 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_SOFTTIMER_H
+#define M328P_SOFTTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Timer1.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    template <typename Clock>
+    class SoftTimerService;
+    
+    /**
+    @brief Software timer managed by SoftTimerService
+    The timer object is linked into the list of active timers while running, so it must outlive its active period.
+    */
+    class SoftTimer
+    {
+        public:
+        
+        /// Timer expiration callback. The callback is executed in interrupt context
+        typedef void (*Callback)();
+        
+        /**
+        @brief Constructor
+        @param callback Callback to be executed when the timer expires
+        */
+        explicit SoftTimer(const Callback callback) :
+        m_callback(callback),
+        m_next(nullptr),
+        m_deadline(0),
+        m_period(0),
+        m_active(false)
+        {}
+        
+        /**
+        @brief Check if the timer is running
+        @result Flag indicating the timer is running
+        */
+        [[nodiscard]] bool isActive() const
+        {
+            return m_active;
+        }
+        
+        private:
+        
+        template <typename Clock>
+        friend class SoftTimerService;
+        
+        // Expiration callback
+        const Callback m_callback;
+        
+        // Next timer in the list of active timers
+        SoftTimer * volatile m_next;
+        
+        // Absolute deadline in system clock ticks
+        uint32_t m_deadline;
+        
+        // Reload period in system clock ticks. 0 for one-shot timers
+        uint32_t m_period;
+        
+        // Flag indicating the timer is in the list of active timers
+        volatile bool m_active;
+    };
+    
+    /**
+    @brief Tickless software timer service based on Timer1 compare match A
+    Active timers are kept in a list sorted by deadline. Only the nearest deadline is loaded into OCR1A, so the compare match
+    interrupt fires only when a timer expires. Deadlines beyond the current counter period are armed from the overflow interrupt.
+    The service uses the time base of a SystemClock, which has to be initialized beforehand.
+    
+    Usage:
+    @code
+    typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_64> Clock;
+    typedef m328p::SoftTimerService<Clock> Timers;
+    
+    void blink();
+    m328p::SoftTimer blinkTimer(blink);
+    
+    int main()
+    {
+        Clock::init();
+        sei();
+        Timers::start(blinkTimer, Clock::toTicks(500000), Clock::toTicks(500000));
+        ...
+    }
+    
+    void m328p::Timer1::handleOVF()
+    {
+        Clock::handleOverflow();
+        Timers::handleOverflow();
+    }
+    
+    void m328p::Timer1::handleCOMPA()
+    {
+        Timers::handleCompareMatch();
+    }
+    @endcode
+    
+    @tparam Clock System clock providing the time base, see SystemClock
+    */
+    template <typename Clock>
+    class SoftTimerService
+    {
+        public:
+        
+        /// Time stamp and duration in system clock ticks
+        typedef typename Clock::Ticks Ticks;
+        
+        /**
+        @brief Start a timer. A running timer is restarted
+        @param timer Timer to be started
+        @param delay Delay until the first expiration in system clock ticks
+        @param period Reload period in system clock ticks. 0 for one-shot timers
+        */
+        static void start(SoftTimer & timer, const Ticks delay, const Ticks period = 0)
+        {
+            Atomic atomic;
+            
+            remove(timer);
+            timer.m_deadline = Clock::now() + delay;
+            timer.m_period = period;
+            insert(timer);
+            schedule();
+        }
+        
+        /**
+        @brief Stop a timer
+        @param timer Timer to be stopped
+        */
+        static void stop(SoftTimer & timer)
+        {
+            Atomic atomic;
+            
+            remove(timer);
+            schedule();
+        }
+        
+        /**
+        @brief Timer1 compare match A handler
+        @note This method has to be called from Timer1::handleCOMPA()
+        */
+        static void handleCompareMatch()
+        {
+            // Process all expired timers. Callbacks may start or stop timers
+            while (s_head != nullptr && isDue(s_head->m_deadline, Clock::now()))
+            {
+                SoftTimer * const timer = s_head;
+                s_head = timer->m_next;
+                timer->m_active = false;
+                
+                if (timer->m_period != 0)
+                {
+                    timer->m_deadline += timer->m_period;
+                    insert(*timer);
+                }
+                
+                timer->m_callback();
+            }
+            
+            schedule();
+        }
+        
+        /**
+        @brief Timer1 overflow handler
+        @note This method has to be called from Timer1::handleOVF() after the system clock overflow handler
+        */
+        static void handleOverflow()
+        {
+            // Arm compare match for deadlines which have come within reach of the 16-bit compare register
+            if (s_head != nullptr && !s_armed)
+            {
+                schedule();
+            }
+        }
+        
+        private:
+        
+        // Minimum distance between counter and compare value in ticks, covering the execution time of schedule()
+        static constexpr uint16_t c_minimumLead = 64 / Clock::getPrescaler() + 2;
+        
+        // Check if a deadline has been reached
+        static bool isDue(const Ticks deadline, const Ticks now) __attribute__((always_inline))
+        {
+            return static_cast<int32_t>(deadline - now) <= 0;
+        }
+        
+        // Insert a timer into the list of active timers, sorted by deadline. Interrupts must be disabled
+        static void insert(SoftTimer & timer)
+        {
+            SoftTimer * volatile * link = &s_head;
+            while (*link != nullptr && static_cast<int32_t>((*link)->m_deadline - timer.m_deadline) <= 0)
+            {
+                link = &(*link)->m_next;
+            }
+            
+            timer.m_next = *link;
+            *link = &timer;
+            timer.m_active = true;
+        }
+        
+        // Remove a timer from the list of active timers. Interrupts must be disabled
+        static void remove(SoftTimer & timer)
+        {
+            if (!timer.m_active)
+            {
+                return;
+            }
+            
+            SoftTimer * volatile * link = &s_head;
+            while (*link != &timer)
+            {
+                link = &(*link)->m_next;
+            }
+            
+            *link = timer.m_next;
+            timer.m_active = false;
+        }
+        
+        // Load the nearest deadline into OCR1A. Interrupts must be disabled
+        static void schedule()
+        {
+            while (s_head != nullptr)
+            {
+                const Ticks deadline = s_head->m_deadline;
+                const Ticks now = Clock::now();
+                const int32_t remaining = static_cast<int32_t>(deadline - now);
+                
+                // Deadline out of reach of the compare register. Compare match will be armed from the overflow handler
+                if (remaining > 0xFFFF)
+                {
+                    break;
+                }
+                
+                // Deadline too close (or already passed), so the compare match is moved to the nearest safe position
+                const uint16_t distance = (remaining < c_minimumLead) ? c_minimumLead : static_cast<uint16_t>(remaining);
+                const uint16_t counter = static_cast<uint16_t>(now);
+                Timer1::writeCompareA(static_cast<uint16_t>(counter + distance));
+                Timer1::clearCompareMatchAFlag();
+                Timer1::enableCompareMatchAInterrupt();
+                
+                // Verify the counter has not passed the compare value meanwhile. The elapsed ticks are compared unsigned against
+                // the armed distance, so distances above 0x7FFF are valid as well
+                if (static_cast<uint16_t>(Timer1::readCounter() - counter) < distance)
+                {
+                    s_armed = true;
+                    return;
+                }
+            }
+            
+            Timer1::disableCompareMatchAInterrupt();
+            s_armed = false;
+        }
+        
+        // Head of the list of active timers
+        inline static SoftTimer * volatile s_head = nullptr;
+        
+        // Flag indicating the compare match interrupt is armed
+        inline static volatile bool s_armed = false;
+    };
+}
+
+#endif
@@ -0,0 +1,248 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_SYSTEMCLOCK_H
+#define M328P_SYSTEMCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_Timer1.h"
+
+namespace m328p
+{
+    /**
+    @brief Monotonic 32-bit system clock based on Timer1
+    Timer1 is used as a free-running 16-bit counter in normal mode. The timer overflow interrupt extends the counter to 32 bits.
+    Reading the clock does not disable interrupts, except for the two byte accesses to TCNT1.
+    
+    Usage:
+    @code
+    typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_8> Clock;
+    
+    int main()
+    {
+        Clock::init();
+        sei();
+        
+        const Clock::Ticks start = Clock::now();
+        ...
+        const uint32_t elapsed = Clock::getElapsedMicroseconds(start);
+    }
+    
+    // Timer1 overflow interrupt handler
+    void m328p::Timer1::handleOVF()
+    {
+        Clock::handleOverflow();
+    }
+    @endcode
+    
+    @tparam t_cpuClock CPU clock frequency in Hz
+    @tparam t_clockSelect Timer1 clock selection. Only internal prescaler settings are supported
+    */
+    template <uint32_t t_cpuClock, Timer1::ClockSelect t_clockSelect>
+    class SystemClock
+    {
+        public:
+        
+        /// Time stamp in timer clock ticks
+        typedef uint32_t Ticks;
+        
+        /**
+        @brief Initialization. Timer1 is configured as free-running counter and the overflow interrupt is enabled
+        */
+        static void init()
+        {
+            Timer1::init(
+            Timer1::WaveformGenerationMode::NORMAL,
+            t_clockSelect,
+            Timer1::CompareOutputMode::DISCONNECTED,
+            Timer1::CompareOutputMode::DISCONNECTED);
+            
+            Timer1::enableOverflowInterrupt();
+        }
+        
+        /**
+        @brief Timer1 overflow handler
+        @note This method has to be called from Timer1::handleOVF()
+        */
+        static void handleOverflow() __attribute__((always_inline))
+        {
+            s_overflowCount = s_overflowCount + 1;
+        }
+        
+        /**
+        @brief Get current time stamp
+        This method can be called from any context. Instead of disabling interrupts, the overflow count is re-read until it is
+        consistent with the counter value. An overflow which has occurred but has not been handled yet (e.g. when called from
+        an interrupt handler) is detected by the overflow flag.
+        @result Current time stamp in timer clock ticks
+        */
+        [[nodiscard]] static Ticks now()
+        {
+            uint16_t overflowCount;
+            uint16_t counter;
+            bool overflowPending;
+            
+            do
+            {
+                overflowCount = s_overflowCount;
+                counter = Timer1::readCounter<Timer1::Access::GUARDED>();
+                overflowPending = Timer1::isOverflowPending();
+            }
+            while (overflowCount != s_overflowCount);
+            
+            // The overflow is only accounted for if the counter has been read after wrapping around
+            if (overflowPending && (counter < 0x8000))
+            {
+                ++overflowCount;
+            }
+            
+            return (static_cast<Ticks>(overflowCount) << 16) | counter;
+        }
+        
+        /**
+        @brief Extend a 16-bit counter value captured by hardware (e.g. ICR1) to a 32-bit time stamp
+        @param counter Counter value captured within the current or the previous (unhandled) counter period
+        @result Time stamp in timer clock ticks
+        @note This method has to be called from interrupt context, i.e. the overflow interrupt must not be handled meanwhile
+        */
+        [[nodiscard]] static Ticks extend(const uint16_t counter)
+        {
+            uint16_t overflowCount = s_overflowCount;
+            
+            // A pending overflow only applies to counter values captured after wrapping around
+            if (Timer1::isOverflowPending() && (counter < 0x8000))
+            {
+                ++overflowCount;
+            }
+            
+            return (static_cast<Ticks>(overflowCount) << 16) | counter;
+        }
+        
+        /**
+        @brief Get the time elapsed since a given time stamp
+        @param since Time stamp obtained by now()
+        @result Elapsed time in timer clock ticks
+        */
+        [[nodiscard]] static Ticks getElapsedTicks(const Ticks since)
+        {
+            return now() - since;
+        }
+        
+        /**
+        @brief Get the time elapsed since a given time stamp
+        @param since Time stamp obtained by now()
+        @result Elapsed time in microseconds
+        */
+        [[nodiscard]] static uint32_t getElapsedMicroseconds(const Ticks since)
+        {
+            return toMicroseconds(getElapsedTicks(since));
+        }
+        
+        /**
+        @brief Convert a duration in timer clock ticks to microseconds
+        @param ticks Duration in timer clock ticks
+        @result Duration in microseconds
+        @note Convert durations rather than time stamps, as the microsecond range will not wrap around together with the tick range
+        */
+        [[nodiscard]] static constexpr uint32_t toMicroseconds(const Ticks ticks)
+        {
+            return convert<c_microsecondsPerTickNum, c_microsecondsPerTickDen>(ticks);
+        }
+        
+        /**
+        @brief Convert a duration in microseconds to timer clock ticks
+        @param microseconds Duration in microseconds
+        @result Duration in timer clock ticks
+        */
+        [[nodiscard]] static constexpr Ticks toTicks(const uint32_t microseconds)
+        {
+            return convert<c_microsecondsPerTickDen, c_microsecondsPerTickNum>(microseconds);
+        }
+        
+        /**
+        @brief Get the timer clock prescaler
+        @result Prescaler division factor
+        */
+        static constexpr uint16_t getPrescaler()
+        {
+            return c_prescaler;
+        }
+        
+        /**
+        @brief Get the timer clock frequency
+        @result Timer clock frequency in Hz
+        */
+        static constexpr uint32_t getTickFrequency()
+        {
+            return t_cpuClock / c_prescaler;
+        }
+        
+        private:
+        
+        // Greatest common divisor
+        static constexpr uint32_t gcd(const uint32_t a, const uint32_t b)
+        {
+            return (b == 0) ? a : gcd(b, a % b);
+        }
+        
+        // Check if a value is a power of two
+        static constexpr bool isPowerOfTwo(const uint32_t value)
+        {
+            return (value & (value - 1)) == 0;
+        }
+        
+        // Binary logarithm of a power of two
+        static constexpr uint8_t log2(const uint32_t value)
+        {
+            return (value <= 1) ? 0 : 1 + log2(value >> 1);
+        }
+        
+        // Scale a value by a constant fraction. All branches are resolved at compile time
+        template <uint32_t t_num, uint32_t t_den>
+        static constexpr uint32_t convert(const uint32_t value)
+        {
+            if constexpr (t_den == 1)
+            {
+                return value * t_num;
+            }
+            else if constexpr (t_num == 1 && isPowerOfTwo(t_den))
+            {
+                return value >> log2(t_den);
+            }
+            else
+            {
+                static_assert((t_den - 1) <= UINT32_MAX / t_num, "Conversion factor out of range for this CPU clock!");
+                return (value / t_den) * t_num + ((value % t_den) * t_num) / t_den;
+            }
+        }
+        
+        // Timer clock prescaler
+        static constexpr uint32_t c_prescaler = Timer1::getPrescaler(t_clockSelect);
+        static_assert(c_prescaler != 0, "Invalid clock selection: Only internal prescaler settings are supported!");
+        
+        // Duration of one tick in microseconds as reduced fraction
+        static constexpr uint32_t c_gcd = gcd(c_prescaler * 1000000UL, t_cpuClock);
+        static constexpr uint32_t c_microsecondsPerTickNum = c_prescaler * 1000000UL / c_gcd;
+        static constexpr uint32_t c_microsecondsPerTickDen = t_cpuClock / c_gcd;
+        
+        // Number of timer overflows (upper 16 bits of the time stamp)
+        inline static volatile uint16_t s_overflowCount = 0;
+    };
+}
+
+#endif
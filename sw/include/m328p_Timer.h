@@ -0,0 +1,756 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_TIMER_H
+#define M328P_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/interrupt.h>
+#include "register_access.h"
+#include "m328p_GPIO.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Access mode for the timer registers TCNTn, OCRnA, OCRnB and ICR1
+    The 16-bit registers of Timer1 share a single TEMP register for the high byte. The register accessors always access
+    the low and high byte in the order required by the TEMP mechanism. However, if an interrupt handler accesses any 16-bit
+    register of Timer1 in between, TEMP will be corrupted. Guarded access disables interrupts for the two byte accesses only.
+    For the 8-bit timers, both access modes are identical.
+    */
+    enum class TimerAccess : uint8_t
+    {
+        UNGUARDED, // Interrupt context, or no interrupt handler accesses 16-bit registers of Timer1
+        GUARDED // Interrupts are disabled for the two byte accesses
+    };
+
+    /**
+    @brief 16-bit timer register accessed via TEMP
+    @tparam Low Low byte register
+    @tparam High High byte register
+    */
+    template <typename Low, typename High>
+    struct TimerRegister16
+    {
+        static uint16_t read() __attribute__((always_inline))
+        {
+            // Reading the low byte latches the high byte into TEMP
+            const uint8_t low = Low::read();
+            return (static_cast<uint16_t>(High::read()) << 8) | low;
+        }
+
+        static void write(const uint16_t value) __attribute__((always_inline))
+        {
+            // The high byte is stored in TEMP and written together with the low byte
+            High::write(static_cast<uint8_t>(value >> 8));
+            Low::write(static_cast<uint8_t>(value));
+        }
+    };
+
+    /**
+    @brief Timer properties and SFR definitions
+    @tparam t_timerIdx Timer index (0..2)
+    */
+    template <uint8_t t_timerIdx>
+    struct TimerTraits;
+
+    /**
+    @brief Timer properties and SFR definitions for Timer0
+    */
+    template <>
+    struct TimerTraits<0>
+    {
+        /// Counter type (timer width)
+        typedef uint8_t Counter;
+
+        /// Waveform Generation Mode
+        enum class WaveformGenerationMode : uint8_t
+        {
+            NORMAL = 0,             // Normal / TOP: 0xFF / Update of OCRx at: Immediate / TOV Flag Set on: MAX
+            PWM_PHASE_CORRECT_1 = 0b001,    // PWM, Phase  Correct / TOP: 0xFF / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
+            CTC = 0b010,            // CTC / TOP: OCRA / Update of OCRx at: Immediate / TOV Flag Set on: MAX
+            PWM_FAST_1 = 0b011,     // Fast PWM / TOP: 0xFF / Update of OCRx at: BOTTOM / TOV Flag Set on: MAX
+            PWM_PHASE_CORRECT_2 = 0b101,    // PWM, Phase Correct / TOP: OCRA / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
+            PWM_FAST_2 = 0b111      // Fast PWM / TOP: OCRA / Update of OCRx at: BOTTOM / TOV Flag Set on: TOP
+        };
+
+        /// Clock Select
+        enum class ClockSelect : uint8_t
+        {
+            NONE = 0, // No clock source (Timer/Counter stopped)
+            PRESCALER_1 = 0b001, // clkI/O (No prescaling)
+            PRESCALER_8 = 0b010, // clkI/O/8 (From prescaler)
+            PRESCALER_64 = 0b011, // clkI/O/64 (From prescaler)
+            PRESCALER_256 = 0b100, // clkI/O/256 (From prescaler)
+            PRESCALER_1024 = 0b101, // clkI/O/1024 (From prescaler)
+            EXT_FALLING = 0b110, // External clock source on T0 pin. Clock on falling edge.
+            EXT_RISING = 0b111, // External clock source on T0 pin. Clock on rising edge.
+        };
+
+        // Prescaler division factor. 0 if the timer is stopped or clocked externally
+        static constexpr uint16_t getPrescaler(const ClockSelect clockSelect)
+        {
+            switch (clockSelect)
+            {
+                case ClockSelect::PRESCALER_1: return 1;
+                case ClockSelect::PRESCALER_8: return 8;
+                case ClockSelect::PRESCALER_64: return 64;
+                case ClockSelect::PRESCALER_256: return 256;
+                case ClockSelect::PRESCALER_1024: return 1024;
+                default: return 0;
+            }
+        }
+
+        // Capabilities
+        static constexpr bool c_hasInputCapture = false;
+        static constexpr bool c_hasAsynchronousMode = false;
+
+        // Interrupt vector numbers. The interrupt handlers are declared by Timer0, as asm labels cannot depend on template parameters
+        static constexpr uint8_t c_compareMatchAVector = 14;
+        static constexpr uint8_t c_compareMatchBVector = 15;
+        static constexpr uint8_t c_overflowVector = 16;
+
+        // Output compare pins
+        typedef GPIOPin<Port::D, 6> OCA_Pin;
+        typedef GPIOPin<Port::D, 5> OCB_Pin;
+
+        // Timer/Counter Control Register A
+        typedef BitGroupInRegister<TCCR0A, COM0A0, COM0A1> COMA;
+        typedef BitGroupInRegister<TCCR0A, COM0B0, COM0B1> COMB;
+
+        // Timer/Counter Control Register B
+        typedef BitInRegister<TCCR0B, FOC0A> FOCA;
+        typedef BitInRegister<TCCR0B, FOC0B> FOCB;
+        typedef BitGroupInRegister<TCCR0B, CS00, CS02, ClockSelect> CS;
+
+        // Timer/Counter Register
+        typedef TCNT0 TCNT;
+
+        // Output Compare Register A
+        typedef OCR0A OCRA;
+
+        // Output Compare Register B
+        typedef OCR0B OCRB;
+
+        // Timer/Counter Interrupt Mask Register
+        typedef BitInRegister<TIMSK0, OCIE0B> OCIEB;
+        typedef BitInRegister<TIMSK0, OCIE0A> OCIEA;
+        typedef BitInRegister<TIMSK0, TOIE0> TOIE;
+
+        // Timer/Counter Interrupt Flag Register
+        typedef TIFR0 TIFR;
+        typedef BitInRegister<TIFR0, TOV0> TOV;
+        static constexpr uint8_t c_OCFB = OCF0B;
+        static constexpr uint8_t c_OCFA = OCF0A;
+        static constexpr uint8_t c_TOV = TOV0;
+
+        // Waveform generation mode
+        struct WGM
+        {
+            static void write(const WaveformGenerationMode waveformGenerationMode)
+            {
+                BitGroupInRegister<TCCR0A, WGM00, WGM01, uint8_t>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b11);
+                BitInRegister<TCCR0B, WGM02>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b100);
+            }
+
+            static WaveformGenerationMode read()
+            {
+                uint8_t waveformGenerationMode = BitGroupInRegister<TCCR0A, WGM00, WGM01, uint8_t>::read();
+                if (BitInRegister<TCCR0B, WGM02>::read())
+                {
+                    waveformGenerationMode |= 0b100;
+                }
+                return static_cast<WaveformGenerationMode>(waveformGenerationMode);
+            }
+        };
+    };
+
+    /**
+    @brief Timer properties and SFR definitions for Timer1
+    */
+    template <>
+    struct TimerTraits<1>
+    {
+        /// Counter type (timer width)
+        typedef uint16_t Counter;
+
+        /// Waveform Generation Mode
+        enum class WaveformGenerationMode : uint8_t
+        {
+            NORMAL = 0,
+            PWM_PHASE_CORRECT_8BIT = 0b0001,
+            PWM_PHASE_CORRECT_9BIT = 0b0010,
+            PWM_PHASE_CORRECT_10BIT = 0b0011,
+            CTC_1 = 0b0100,
+            PWM_FAST_CORRECT_8BIT = 0b0101,
+            PWM_FAST_CORRECT_9BIT = 0b0110,
+            PWM_FAST_CORRECT_10BIT = 0b0111,
+            PWM_PHASE_CORRECT_FREQ_1 = 0b1000,
+            PWM_PHASE_CORRECT_FREQ_2 = 0b1001,
+            PWM_PHASE_CORRECT_1 = 0b1010,
+            PWM_PHASE_CORRECT_2 = 0b1011,
+            CTC_2 = 0b1100,
+            PWM_FAST_1 = 0b1110,
+            PWM_FAST_2 = 0b1111,
+        };
+
+        /// Clock Select
+        enum class ClockSelect : uint8_t
+        {
+            NONE = 0,
+            PRESCALER_1 = 0b001,
+            PRESCALER_8 = 0b010,
+            PRESCALER_64 = 0b011,
+            PRESCALER_256 = 0b100,
+            PRESCALER_1024 = 0b101,
+            EXT_FALLING = 0b110,
+            EXT_RISING = 0b111,
+        };
+
+        // Prescaler division factor. 0 if the timer is stopped or clocked externally
+        static constexpr uint16_t getPrescaler(const ClockSelect clockSelect)
+        {
+            switch (clockSelect)
+            {
+                case ClockSelect::PRESCALER_1: return 1;
+                case ClockSelect::PRESCALER_8: return 8;
+                case ClockSelect::PRESCALER_64: return 64;
+                case ClockSelect::PRESCALER_256: return 256;
+                case ClockSelect::PRESCALER_1024: return 1024;
+                default: return 0;
+            }
+        }
+
+        // Capabilities
+        static constexpr bool c_hasInputCapture = true;
+        static constexpr bool c_hasAsynchronousMode = false;
+
+        // Interrupt vector numbers. The interrupt handlers are declared by Timer1, as asm labels cannot depend on template parameters
+        static constexpr uint8_t c_inputCaptureVector = 10;
+        static constexpr uint8_t c_compareMatchAVector = 11;
+        static constexpr uint8_t c_compareMatchBVector = 12;
+        static constexpr uint8_t c_overflowVector = 13;
+
+        // Output compare pins
+        typedef GPIOPin<Port::B, 1> OCA_Pin;
+        typedef GPIOPin<Port::B, 2> OCB_Pin;
+
+        // Compare Output Mode for channel A/B
+        typedef BitGroupInRegister<TCCR1A, COM1A0, COM1A1> COMA;
+        typedef BitGroupInRegister<TCCR1A, COM1B0, COM1B1> COMB;
+
+        // Input Capture Noise Canceler
+        typedef BitInRegister<TCCR1B, ICNC1> ICNC;
+
+        // Input Capture Edge Select
+        typedef BitInRegister<TCCR1B, ICES1> ICES;
+
+        // Clock Select
+        typedef BitGroupInRegister<TCCR1B, CS10, CS12, ClockSelect> CS;
+
+        // Force Output Compare channel A/B
+        typedef BitInRegister<TCCR1C, FOC1A> FOCA;
+        typedef BitInRegister<TCCR1C, FOC1B> FOCB;
+
+        // Timer/Counter Register
+        typedef TimerRegister16<TCNT1L, TCNT1H> TCNT;
+
+        // Output Compare Register A
+        typedef TimerRegister16<OCR1AL, OCR1AH> OCRA;
+
+        // Output Compare Register B
+        typedef TimerRegister16<OCR1BL, OCR1BH> OCRB;
+
+        // Input Capture Register
+        typedef TimerRegister16<ICR1L, ICR1H> ICR;
+
+        // Timer/Counter Interrupt Mask Register
+        typedef BitInRegister<TIMSK1, ICIE1> ICIE;
+        typedef BitInRegister<TIMSK1, OCIE1B> OCIEB;
+        typedef BitInRegister<TIMSK1, OCIE1A> OCIEA;
+        typedef BitInRegister<TIMSK1, TOIE1> TOIE;
+
+        // Timer/Counter Interrupt Flag Register
+        typedef TIFR1 TIFR;
+        typedef BitInRegister<TIFR1, TOV1> TOV;
+        static constexpr uint8_t c_ICF = ICF1;
+        static constexpr uint8_t c_OCFB = OCF1B;
+        static constexpr uint8_t c_OCFA = OCF1A;
+        static constexpr uint8_t c_TOV = TOV1;
+
+        // Waveform generation mode
+        struct WGM
+        {
+            static void write(const WaveformGenerationMode waveformGenerationMode)
+            {
+                BitGroupInRegister<TCCR1A, WGM10, WGM11>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b11);
+                BitGroupInRegister<TCCR1B, WGM12, WGM13>::write(static_cast<uint8_t>(waveformGenerationMode) >> 2);
+            }
+
+            static WaveformGenerationMode read()
+            {
+                uint8_t waveformGenerationMode = BitGroupInRegister<TCCR1B, WGM12, WGM13>::read() << 2;
+                waveformGenerationMode |= BitGroupInRegister<TCCR1A, WGM10, WGM11>::read();
+                return static_cast<WaveformGenerationMode>(waveformGenerationMode);
+            }
+        };
+    };
+
+    /**
+    @brief Timer properties and SFR definitions for Timer2
+    */
+    template <>
+    struct TimerTraits<2>
+    {
+        /// Counter type (timer width)
+        typedef uint8_t Counter;
+
+        /// Waveform Generation Mode
+        enum class WaveformGenerationMode : uint8_t
+        {
+            NORMAL = 0,      // Normal / TOP: 0xFF / Update of OCRx at: Immediate / TOV Flag Set on: MAX
+            PWM_PHASE_CORRECT_1 = 0b001, // PWM, Phase  Correct / TOP: 0xFF / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
+            CTC = 0b010,         // CTC / TOP: OCRA / Update of OCRx at: Immediate / TOV Flag Set on: MAX
+            PWM_FAST_1 = 0b011,  // Fast PWM / TOP: 0xFF / Update of OCRx at: BOTTOM / TOV Flag Set on: MAX
+            PWM_PHASE_CORRECT_2 = 0b101, // PWM, Phase Correct / TOP: OCRA / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
+            PWM_FAST_2 = 0b111   // Fast PWM / TOP: OCRA / Update of OCRx at: BOTTOM / TOV Flag Set on: TOP
+        };
+
+        /// Clock Select
+        enum class ClockSelect : uint8_t
+        {
+            NONE = 0, // No clock source (Timer/Counter stopped)
+            PRESCALER_1 = 0b001, // clk/1(No prescaling)
+            PRESCALER_8 = 0b010, // clk/8 (From prescaler)
+            PRESCALER_32 = 0b011, // clk/32 (From prescaler)
+            PRESCALER_64 = 0b100, // clk/64 (From prescaler)
+            PRESCALER_128 = 0b101, // clk/128 (From prescaler)
+            PRESCALER_256 = 0b110, // clk/256 (From prescaler)
+            PRESCALER_1024 = 0b111 // clk/1024 (From prescaler)
+        };
+
+        // Prescaler division factor. 0 if the timer is stopped
+        static constexpr uint16_t getPrescaler(const ClockSelect clockSelect)
+        {
+            switch (clockSelect)
+            {
+                case ClockSelect::PRESCALER_1: return 1;
+                case ClockSelect::PRESCALER_8: return 8;
+                case ClockSelect::PRESCALER_32: return 32;
+                case ClockSelect::PRESCALER_64: return 64;
+                case ClockSelect::PRESCALER_128: return 128;
+                case ClockSelect::PRESCALER_256: return 256;
+                case ClockSelect::PRESCALER_1024: return 1024;
+                default: return 0;
+            }
+        }
+
+        // Capabilities
+        static constexpr bool c_hasInputCapture = false;
+        static constexpr bool c_hasAsynchronousMode = true;
+
+        // Interrupt vector numbers. The interrupt handlers are declared by Timer2, as asm labels cannot depend on template parameters
+        static constexpr uint8_t c_compareMatchAVector = 7;
+        static constexpr uint8_t c_compareMatchBVector = 8;
+        static constexpr uint8_t c_overflowVector = 9;
+
+        // Output compare pins
+        typedef GPIOPin<Port::B, 3> OCA_Pin;
+        typedef GPIOPin<Port::D, 3> OCB_Pin;
+
+        // Timer/Counter Control Register A
+        typedef BitGroupInRegister<TCCR2A, COM2A0, COM2A1> COMA;
+        typedef BitGroupInRegister<TCCR2A, COM2B0, COM2B1> COMB;
+
+        // Timer/Counter Control Register B
+        typedef BitInRegister<TCCR2B, FOC2A> FOCA;
+        typedef BitInRegister<TCCR2B, FOC2B> FOCB;
+        typedef BitGroupInRegister<TCCR2B, CS20, CS22, ClockSelect> CS;
+
+        // Timer/Counter Register
+        typedef TCNT2 TCNT;
+
+        // Output Compare Register A
+        typedef OCR2A OCRA;
+
+        // Output Compare Register B
+        typedef OCR2B OCRB;
+
+        // Timer/Counter Interrupt Mask Register
+        typedef BitInRegister<TIMSK2, OCIE2B> OCIEB;
+        typedef BitInRegister<TIMSK2, OCIE2A> OCIEA;
+        typedef BitInRegister<TIMSK2, TOIE2> TOIE;
+
+        // Timer/Counter Interrupt Flag Register
+        typedef TIFR2 TIFR;
+        typedef BitInRegister<TIFR2, TOV2> TOV;
+        static constexpr uint8_t c_OCFB = OCF2B;
+        static constexpr uint8_t c_OCFA = OCF2A;
+        static constexpr uint8_t c_TOV = TOV2;
+
+        // Asynchronous Status Register
+        typedef BitInRegister<ASSR, EXCLK> EXCLK_Bit;
+        typedef BitInRegister<ASSR, AS2> AS2_Bit;
+        typedef BitInRegister<ASSR, TCR2AUB> TCR2AUB_Bit;
+
+        // Waveform generation mode
+        struct WGM
+        {
+            static void write(const WaveformGenerationMode waveformGenerationMode)
+            {
+                BitGroupInRegister<TCCR2A, WGM20, WGM21>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b11);
+                BitInRegister<TCCR2B, WGM22>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b100);
+            }
+
+            static WaveformGenerationMode read()
+            {
+                uint8_t waveformGenerationMode = BitGroupInRegister<TCCR2A, WGM20, WGM21>::read();
+                if (BitInRegister<TCCR2B, WGM22>::read())
+                {
+                    waveformGenerationMode |= 0b100;
+                }
+                return static_cast<WaveformGenerationMode>(waveformGenerationMode);
+            }
+        };
+    };
+
+    /**
+    @brief Generic register-level driver for the timers on ATMega328P
+    All properties of the timer (width, prescaler table, registers, capabilities) are taken from TimerTraits and resolved at
+    compile time. Services written against this interface can be instantiated on any timer at zero runtime cost.
+    The timer-specific classes Timer0, Timer1 and Timer2 derive from this class and add the interrupt handlers as well as
+    features only available on that timer (input capture, asynchronous operation).
+    @tparam t_timerIdx Timer index (0..2)
+    */
+    template <uint8_t t_timerIdx>
+    class Timer
+    {
+        protected:
+
+        // Timer properties and SFR definitions
+        typedef TimerTraits<t_timerIdx> Traits;
+
+        public:
+
+        ///@brief Counter type (timer width)
+        typedef typename Traits::Counter Counter;
+
+        ///@brief Waveform Generation Mode
+        typedef typename Traits::WaveformGenerationMode WaveformGenerationMode;
+
+        ///@brief Clock Select
+        typedef typename Traits::ClockSelect ClockSelect;
+
+        ///@brief Compare Output Mode
+        enum class CompareOutputMode : uint8_t
+        {
+            DISCONNECTED = 0, // Normal port operation, OCx disconnected.
+            TOGGLE = 0b01, // Toggle OCx on Compare Match
+            CLEAR = 0b10, // Clear OCx on Compare Match
+            SET = 0b11  // Set OCx on Compare Match
+        };
+
+        ///@brief Register access mode, see TimerAccess
+        typedef TimerAccess Access;
+
+        ///@brief Output compare pin A
+        typedef typename Traits::OCA_Pin OCA_Pin;
+
+        ///@brief Output compare pin B
+        typedef typename Traits::OCB_Pin OCB_Pin;
+
+        /**
+        @brief Get the timer index
+        @result Timer index (0..2)
+        */
+        static constexpr uint8_t getIndex()
+        {
+            return t_timerIdx;
+        }
+
+        /**
+        @brief Get the maximum counter value
+        @result MAX (0xFF or 0xFFFF)
+        */
+        static constexpr Counter getMax()
+        {
+            return static_cast<Counter>(~0);
+        }
+
+        /**
+        @brief Check if the timer supports input capture
+        @result Flag indicating the timer supports input capture
+        */
+        static constexpr bool hasInputCapture()
+        {
+            return Traits::c_hasInputCapture;
+        }
+
+        /**
+        @brief Check if the timer supports asynchronous operation
+        @result Flag indicating the timer can be clocked from a 32.768 kHz crystal
+        */
+        static constexpr bool hasAsynchronousMode()
+        {
+            return Traits::c_hasAsynchronousMode;
+        }
+
+        /**
+        @brief Get the prescaler division factor for a given clock selection
+        @param clockSelect Clock selection
+        @result Prescaler division factor. 0 if the timer is stopped or clocked externally
+        */
+        static constexpr uint16_t getPrescaler(const ClockSelect clockSelect)
+        {
+            return Traits::getPrescaler(clockSelect);
+        }
+
+        /**
+        @brief Initialization
+        @param waveformGenerationMode Selected waveform generation mode
+        @param clockSelect Selected clock source
+        @param compareOutputModeA Selected compare output mode for OCxA pin
+        @param compareOutputModeB Selected compare output mode for OCxB pin
+        */
+        static void init(
+        const WaveformGenerationMode waveformGenerationMode,
+        const ClockSelect clockSelect,
+        const CompareOutputMode compareOutputModeA,
+        const CompareOutputMode compareOutputModeB)
+        {
+            Traits::WGM::write(waveformGenerationMode);
+            Traits::CS::write(clockSelect);
+            Traits::COMA::write(static_cast<uint8_t>(compareOutputModeA));
+            Traits::COMB::write(static_cast<uint8_t>(compareOutputModeB));
+        }
+
+        /**
+        @brief Change the compare output mode of channel A without affecting the timer operation
+        @param compareOutputMode Selected compare output mode for OCxA pin
+        */
+        static void setCompareOutputModeA(const CompareOutputMode compareOutputMode) __attribute__((always_inline))
+        {
+            Traits::COMA::write(static_cast<uint8_t>(compareOutputMode));
+        }
+
+        /**
+        @brief Change the compare output mode of channel B without affecting the timer operation
+        @param compareOutputMode Selected compare output mode for OCxB pin
+        */
+        static void setCompareOutputModeB(const CompareOutputMode compareOutputMode) __attribute__((always_inline))
+        {
+            Traits::COMB::write(static_cast<uint8_t>(compareOutputMode));
+        }
+
+        /**
+        @brief Enable overflow interrupt
+        */
+        static void enableOverflowInterrupt() __attribute__((always_inline))
+        {
+            // Set timer overflow interrupt enable flag
+            Traits::TOIE::set();
+        }
+
+        /**
+        @brief Disable overflow interrupt
+        */
+        static void disableOverflowInterrupt() __attribute__((always_inline))
+        {
+            // Clear timer overflow interrupt enable flag
+            Traits::TOIE::clear();
+        }
+
+        /**
+        @brief Clear a pending overflow interrupt
+        */
+        static void clearOverflowFlag() __attribute__((always_inline))
+        {
+            // Interrupt flags are cleared by writing a logical one
+            Traits::TIFR::write(_BV(Traits::c_TOV));
+        }
+
+        /**
+        @brief Check if a timer overflow is pending, i.e. the overflow flag is set but the interrupt has not been handled yet
+        @result Flag indicating a timer overflow is pending
+        */
+        [[nodiscard]] static bool isOverflowPending() __attribute__((always_inline))
+        {
+            return Traits::TOV::read();
+        }
+
+        /**
+        @brief Enable compare match A interrupt
+        */
+        static void enableCompareMatchAInterrupt() __attribute__((always_inline))
+        {
+            // Set output compare match A interrupt enable flag
+            Traits::OCIEA::set();
+        }
+
+        /**
+        @brief Disable compare match A interrupt
+        */
+        static void disableCompareMatchAInterrupt() __attribute__((always_inline))
+        {
+            // Clear output compare match A interrupt enable flag
+            Traits::OCIEA::clear();
+        }
+
+        /**
+        @brief Clear a pending compare match A interrupt
+        */
+        static void clearCompareMatchAFlag() __attribute__((always_inline))
+        {
+            // Interrupt flags are cleared by writing a logical one
+            Traits::TIFR::write(_BV(Traits::c_OCFA));
+        }
+
+        /**
+        @brief Enable compare match B interrupt
+        */
+        static void enableCompareMatchBInterrupt() __attribute__((always_inline))
+        {
+            // Set output compare match B interrupt enable flag
+            Traits::OCIEB::set();
+        }
+
+        /**
+        @brief Disable compare match B interrupt
+        */
+        static void disableCompareMatchBInterrupt() __attribute__((always_inline))
+        {
+            // Clear output compare match B interrupt enable flag
+            Traits::OCIEB::clear();
+        }
+
+        /**
+        @brief Clear a pending compare match B interrupt
+        */
+        static void clearCompareMatchBFlag() __attribute__((always_inline))
+        {
+            // Interrupt flags are cleared by writing a logical one
+            Traits::TIFR::write(_BV(Traits::c_OCFB));
+        }
+
+        /**
+        @brief Read the counter
+        @tparam t_access Access mode, see TimerAccess
+        @result Current value of TCNTn
+        */
+        template <Access t_access = Access::UNGUARDED>
+        [[nodiscard]] static Counter readCounter()
+        {
+            return read<t_access, typename Traits::TCNT>();
+        }
+
+        /**
+        @brief Write the counter
+        @tparam t_access Access mode, see TimerAccess
+        @param value New value of TCNTn
+        @note Writing the counter blocks a compare match on the following timer clock
+        */
+        template <Access t_access = Access::UNGUARDED>
+        static void writeCounter(const Counter value)
+        {
+            write<t_access, typename Traits::TCNT>(value);
+        }
+
+        /**
+        @brief Read output compare register A
+        @tparam t_access Access mode, see TimerAccess
+        @result Current value of OCRnA
+        @note Reading OCR1A does not involve TEMP. Guarded access is only required if OCR1A is modified by an interrupt handler
+        */
+        template <Access t_access = Access::UNGUARDED>
+        [[nodiscard]] static Counter readCompareA()
+        {
+            return read<t_access, typename Traits::OCRA>();
+        }
+
+        /**
+        @brief Write output compare register A
+        @tparam t_access Access mode, see TimerAccess
+        @param value New value of OCRnA
+        @note In PWM modes, OCRnA is double-buffered and updated at TOP or BOTTOM depending on the waveform generation mode
+        */
+        template <Access t_access = Access::UNGUARDED>
+        static void writeCompareA(const Counter value)
+        {
+            write<t_access, typename Traits::OCRA>(value);
+        }
+
+        /**
+        @brief Read output compare register B
+        @tparam t_access Access mode, see TimerAccess
+        @result Current value of OCRnB
+        @note Reading OCR1B does not involve TEMP. Guarded access is only required if OCR1B is modified by an interrupt handler
+        */
+        template <Access t_access = Access::UNGUARDED>
+        [[nodiscard]] static Counter readCompareB()
+        {
+            return read<t_access, typename Traits::OCRB>();
+        }
+
+        /**
+        @brief Write output compare register B
+        @tparam t_access Access mode, see TimerAccess
+        @param value New value of OCRnB
+        @note In PWM modes, OCRnB is double-buffered and updated at TOP or BOTTOM depending on the waveform generation mode
+        */
+        template <Access t_access = Access::UNGUARDED>
+        static void writeCompareB(const Counter value)
+        {
+            write<t_access, typename Traits::OCRB>(value);
+        }
+
+        protected:
+
+        // Read timer register in the selected access mode. Single byte accesses are atomic anyway
+        template <Access t_access, typename Reg>
+        static Counter read()
+        {
+            if constexpr (t_access == Access::GUARDED && sizeof(Counter) > 1)
+            {
+                Atomic atomic;
+                return Reg::read();
+            }
+            else
+            {
+                return Reg::read();
+            }
+        }
+
+        // Write timer register in the selected access mode. Single byte accesses are atomic anyway
+        template <Access t_access, typename Reg>
+        static void write(const Counter value)
+        {
+            if constexpr (t_access == Access::GUARDED && sizeof(Counter) > 1)
+            {
+                Atomic atomic;
+                Reg::write(value);
+            }
+            else
+            {
+                Reg::write(value);
+            }
+        }
+    };
+}
+
+#endif
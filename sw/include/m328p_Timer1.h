@@ -20,157 +20,106 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <avr/interrupt.h>
-#include "register_access.h"
+#include "m328p_Timer.h"
 
 
 namespace m328p
 {
     /**
     @brief Register-level driver class for Timer1 on ATMega328P
+    The register interface is provided by the generic Timer class, see m328p_Timer.h. This class adds input capture
     */
-    class Timer1
+    class Timer1 : public Timer<1>
     {
         public:
 
-        ///@brief Waveform Generation Mode
-        enum class WaveformGenerationMode : uint8_t
+        ///@brief Input Capture Edge Select
+        enum class InputCaptureEdge : uint8_t
         {
-            NORMAL = 0,
-            PWM_PHASE_CORRECT_8BIT = 0b0001,
-            PWM_PHASE_CORRECT_9BIT = 0b0010,
-            PWM_PHASE_CORRECT_10BIT = 0b0011,
-            CTC_1 = 0b0100,
-            PWM_FAST_CORRECT_8BIT = 0b0101,
-            PWM_FAST_CORRECT_9BIT = 0b0110,
-            PWM_FAST_CORRECT_10BIT = 0b0111,
-            PWM_PHASE_CORRECT_FREQ_1 = 0b1000,
-            PWM_PHASE_CORRECT_FREQ_2 = 0b1001,
-            PWM_PHASE_CORRECT_1 = 0b1010,
-            PWM_PHASE_CORRECT_2 = 0b1011,
-            CTC_2 = 0b1100,
-            PWM_FAST_1 = 0b1110,
-            PWM_FAST_2 = 0b1111,
+            FALLING = 0,
+            RISING = 1
         };
 
-        ///@brief Compare Output Mode
-        enum class CompareOutputMode : uint8_t
+        /**
+        @brief Enable input capture interrupt
+        */
+        static void enableInputCaptureInterrupt() __attribute__((always_inline))
         {
-            DISCONNECTED = 0b00,
-            TOGGLE = 0b01,
-            CLEAR = 0b10,
-            SET = 0b11
-        };
+            // Set input capture interrupt enable flag
+            Traits::ICIE::set();
+        }
 
-        ///@brief Clock Select
-        enum class ClockSelect : uint8_t
+        /**
+        @brief Disable input capture interrupt
+        */
+        static void disableInputCaptureInterrupt() __attribute__((always_inline))
         {
-            NONE = 0,
-            PRESCALER_1 = 0b001,
-            PRESCALER_8 = 0b010,
-            PRESCALER_64 = 0b011,
-            PRESCALER_256 = 0b100,
-            PRESCALER_1024 = 0b101,
-            EXT_FALLING = 0b110,
-            EXT_RISING = 0b111,
-        };
-        
+            // Clear input capture interrupt enable flag
+            Traits::ICIE::clear();
+        }
+
         /**
-        @brief Initialization
-        @param waveformGenerationMode Selected waveform generation mode for timer 1
-        @param clockSelect Selected clock source for timer 1
-        @param compareOutputModeA Selected compare output mode for OC0A pin
-        @param compareOutputModeA Selected compare output mode for OC0B pin
+        @brief Clear a pending input capture interrupt
         */
-        static void init(
-        const WaveformGenerationMode waveformGenerationMode,
-        const ClockSelect clockSelect,
-        const CompareOutputMode compareOutputModeA,
-        const CompareOutputMode compareOutputModeB)
+        static void clearInputCaptureFlag() __attribute__((always_inline))
         {
-            WGM::write(waveformGenerationMode);
-            CS::write(clockSelect);
-            COMA::write(compareOutputModeA);
-            COMB::write(compareOutputModeB);
+            // Interrupt flags are cleared by writing a logical one
+            Traits::TIFR::write(_BV(Traits::c_ICF));
         }
-        
+
         /**
-        @brief Enable overflow interrupt
+        @brief Select the input capture trigger edge
+        @param inputCaptureEdge Edge on ICP1 triggering a capture
+        @note Changing the edge may trigger a capture. Clear the input capture flag afterwards, if required
         */
-        static void enableOverflowInterrupt() __attribute__((always_inline))
+        static void setInputCaptureEdge(const InputCaptureEdge inputCaptureEdge) __attribute__((always_inline))
         {
-            // Set timer overflow interrupt enable flag
-            TOIE::set();
+            Traits::ICES::write(inputCaptureEdge == InputCaptureEdge::RISING);
         }
-        
+
         /**
-        @brief Disable overflow interrupt
+        @brief Get the selected input capture trigger edge
+        @result Edge on ICP1 triggering a capture
         */
-        static void disableOverflowInterrupt() __attribute__((always_inline))
+        [[nodiscard]] static InputCaptureEdge getInputCaptureEdge() __attribute__((always_inline))
         {
-            // Clear timer overflow interrupt enable flag
-            TOIE::clear();
+            return Traits::ICES::read() ? InputCaptureEdge::RISING : InputCaptureEdge::FALLING;
         }
-        
-        private:
 
-        // Compare Output Mode for channel A/B
-        typedef BitGroupInRegister<TCCR1A, COM1A0, COM1A1, CompareOutputMode> COMA;
-        typedef BitGroupInRegister<TCCR1A, COM1B0, COM1B1, CompareOutputMode> COMB;
-
-        // Input Capture Noise Canceler
-        typedef BitInRegister<TCCR1C, ICNC1> ICNC;
-
-        // Input Capture Edge Select
-        typedef BitInRegister<TCCR1C, ICES1> ICES;
-
-        // Clock Select
-        typedef BitGroupInRegister<TCCR1B, CS10, CS12, ClockSelect> CS;
-
-        // Force Output Compare channel A/B
-        typedef BitInRegister<TCCR1C, FOC1A> FOCA;
-        typedef BitInRegister<TCCR1C, FOC1B> FOCB;
-
-        // Timer/Counter Register
-        typedef TCNT1 TCNT_Reg;
-        
-        // Output Compare Register A
-        typedef OCR1A OCRA_Reg;
-
-        // Output Compare Register B
-        typedef OCR1B OCRB_Reg;
-
-        // Input Capture Register
-        typedef ICR1 ICR_Reg;
-        
-        // Timer/Counter Interrupt Mask Register
-        typedef BitInRegister<TIMSK1, ICIE1> ICIE;
-        typedef BitInRegister<TIMSK1, OCIE1B> OCIEB;
-        typedef BitInRegister<TIMSK1, OCIE1A> OCIEA;
-        typedef BitInRegister<TIMSK1, TOIE1> TOIE;
-
-        // Timer/Counter 0 Interrupt Flag Register
-        typedef BitInRegister<TIFR1, ICF1> ICF;
-        typedef BitInRegister<TIFR1, OCF1B> OCFB;
-        typedef BitInRegister<TIFR1, OCF1A> OCFA;
-        typedef BitInRegister<TIFR1, TOV1> TOV;
-
-        // WGM Waveform generation mode  
-        struct WGM
+        /**
+        @brief Enable or disable the input capture noise canceler
+        @param enable Flag indicating the noise canceler is enabled. The noise canceler delays a capture by four oscillator cycles
+        */
+        static void enableInputCaptureNoiseCanceler(const bool enable) __attribute__((always_inline))
         {
-            static void write(const WaveformGenerationMode waveformGenerationMode)
-            {
-                BitGroupInRegister<TCCR1A, WGM10, WGM11>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b11);
-                BitGroupInRegister<TCCR1B, WGM12, WGM13>::write((static_cast<uint8_t>(waveformGenerationMode) & 0b11) << 2);
-            }
-
-            static WaveformGenerationMode read()
-            {
-                uint8_t waveformGenerationMode = BitGroupInRegister<TCCR1B, WGM12, WGM13>::read() << 2;
-                waveformGenerationMode |= BitGroupInRegister<TCCR1A, WGM10, WGM11>::read();
-                return static_cast<WaveformGenerationMode>(waveformGenerationMode);
-            }
-        };
-        
+            Traits::ICNC::write(enable);
+        }
+
+        /**
+        @brief Read input capture register
+        @tparam t_access Access mode, see TimerAccess
+        @result Current value of ICR1
+        */
+        template <Access t_access = Access::UNGUARDED>
+        [[nodiscard]] static uint16_t readInputCapture()
+        {
+            return read<t_access, Traits::ICR>();
+        }
+
+        /**
+        @brief Write input capture register
+        @tparam t_access Access mode, see TimerAccess
+        @param value New value of ICR1
+        @note ICR1 can only be written in waveform generation modes using ICR1 as TOP. ICR1 is not double-buffered
+        */
+        template <Access t_access = Access::UNGUARDED>
+        static void writeInputCapture(const uint16_t value)
+        {
+            write<t_access, Traits::ICR>(value);
+        }
+
+        private:
+
         /**
         @brief Input Capture interrupt handler
         @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
@@ -189,8 +138,8 @@ namespace m328p
         */
         static void handleCOMPB() __asm__("__vector_12") __attribute__((__signal__, __used__, __externally_visible__));
 
-       /**
-        Overflow interrupt handler
+        /**
+        @brief Overflow interrupt handler
         @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
         */
         static void handleOVF() __asm__("__vector_13") __attribute__((__signal__, __used__, __externally_visible__));
@@ -20,157 +20,98 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <avr/interrupt.h>
-#include "register_access.h"
+#include "m328p_Timer.h"
 
 namespace m328p
 {
     /**
     @brief Register-level driver class for Timer2 on ATMega328P
-    @note Asynchronous operation is currently not supported!
+    The register interface is provided by the generic Timer class, see m328p_Timer.h. This class adds asynchronous operation
+    @note In asynchronous mode, Timer2 is clocked from a 32.768 kHz crystal on TOSC1/TOSC2 (or an external clock on TOSC1).
+    Writes to TCNT2, OCR2A, OCR2B, TCCR2A and TCCR2B are then synchronized to the asynchronous clock, see waitForUpdate()
     */
-    class Timer2
+    class Timer2 : public Timer<2>
     {
         public:
 
-        ///@brief  Waveform Generation Mode
-        enum class WaveformGenerationMode : uint8_t
-        {
-            NORMAL = 0,      // Normal / TOP: 0xFF / Update of OCRx at: Immediate / TOV Flag Set on: MAX
-            PWM_PHASE_CORRECT_1 = 0b001, // PWM, Phase  Correct / TOP: 0xFF / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
-            CTC = 0b010,         // CTC / TOP: OCRA / Update of OCRx at: Immediate / TOV Flag Set on: MAX
-            PWM_FAST_1 = 0b011,  // Fast PWM / TOP: 0xFF / Update of OCRx at: BOTTOM / TOV Flag Set on: MAX
-            PWM_PHASE_CORRECT_2 = 0b101, // PWM, Phase Correct / TOP: OCRA / Update of OCRx at: TOP / TOV Flag Set on: BOTTOM
-            PWM_FAST_2 = 0b111   // Fast PWM / TOP: OCRA / Update of OCRx at: BOTTOM / TOV Flag Set on: TOP
-        };
-
-        ///@brief  Compare Output Mode
-        enum class CompareOutputMode : uint8_t
-        {
-            DISCONNECTED = 0, // Normal port operation, OC0 disconnected.
-            TOGGLE = 0b01, // Toggle OC0 on Compare Match
-            CLEAR = 0b10, // Clear OC0 on Compare Match
-            SET = 0b11  // Set OC0 on Compare Match
-        };
-
-        ///@brief Clock Select
-        enum class ClockSelect : uint8_t
+        /**
+        @brief Switch to asynchronous operation
+        The Timer2 interrupts are disabled, since switching the clock source may corrupt the timer registers.
+        Re-initialize the timer and wait for the update to complete afterwards.
+        @param externalClock Flag indicating an external clock is applied to TOSC1 instead of a crystal
+        */
+        static void enableAsynchronousMode(const bool externalClock = false)
         {
-            NONE = 0, // No clock source (Timer/Counter stopped)
-            PRESCALER_1 = 0b001, // clk/1(No prescaling)
-            PRESCALER_8 = 0b010, // clk/8 (From prescaler)
-            PRESCALER_32 = 0b011, // clk/32 (From prescaler)
-            PRESCALER_64 = 0b100, // clk/64 (From prescaler)
-            PRESCALER_128 = 0b101, // clk/128 (From prescaler)
-            PRESCALER_256 = 0b110, // clk/256 (From prescaler)
-            PRESCALER_1024 = 0b111 // clk/1024 (From prescaler)
-        };
+            TIMSK2::write(0);
+            Traits::EXCLK_Bit::write(externalClock);
+            Traits::AS2_Bit::set();
+        }
 
         /**
-        @brief Initialization
-        @param waveformGenerationMode Selected waveform generation mode for timer 2
-        @param clockSelect Selected clock source for timer 2
-        @param compareOutputModeA Selected compare output mode for OC0A pin
-        @param compareOutputModeA Selected compare output mode for OC0B pin
+        @brief Switch to synchronous operation (clocked from clkI/O)
         */
-        static void init(
-        const WaveformGenerationMode waveformGenerationMode,
-        const ClockSelect clockSelect,
-        const CompareOutputMode compareOutputModeA,
-        const CompareOutputMode compareOutputModeB)
+        static void disableAsynchronousMode()
         {
-            WGM::write(waveformGenerationMode);
-            CS::write(clockSelect);
-            COMA::write(compareOutputModeA);
-            COMB::write(compareOutputModeB);
+            TIMSK2::write(0);
+            Traits::AS2_Bit::clear();
         }
-        
+
         /**
-        @brief Enable overflow interrupt
+        @brief Check if a register update is pending in asynchronous mode
+        @result Flag indicating any of TCNT2, OCR2A, OCR2B, TCCR2A or TCCR2B is still being synchronized
         */
-        static void enableOverflowInterrupt() __attribute__((always_inline))
+        [[nodiscard]] static bool isUpdateBusy() __attribute__((always_inline))
         {
-            // Set timer overflow interrupt enable flag
-            TOIE::set();
+            return (ASSR::read() & (_BV(TCN2UB) | _BV(OCR2AUB) | _BV(OCR2BUB) | _BV(TCR2AUB) | _BV(TCR2BUB))) != 0;
         }
-        
+
         /**
-        @brief Disable overflow interrupt
+        @brief Wait until all register updates have been synchronized in asynchronous mode
         */
-        static void disableOverflowInterrupt() __attribute__((always_inline))
+        static void waitForUpdate() __attribute__((always_inline))
         {
-            // Clear timer overflow interrupt enable flag
-            TOIE::clear();
+            while (isUpdateBusy());
         }
-        
-        private:
-
-        // TCCR0A  Timer/Counter Control Register A
-        typedef BitGroupInRegister<TCCR2A, COM2A0, COM2A1, CompareOutputMode> COMA;
-        typedef BitGroupInRegister<TCCR2A, COM2B0, COM2B1, CompareOutputMode> COMB;
-
-        // TCCR0B  Timer/Counter Control Register B
-        typedef BitInRegister<TCCR2B, FOC2A> FOCA;
-        typedef BitInRegister<TCCR2B, FOC2B> FOCB;
-        typedef BitGroupInRegister<TCCR2B, CS20, CS22, ClockSelect> CS;
-
-        // TCNT0  Timer/Counter Register
-        typedef TCNT2 TCNT;
-        
-        // OCR0A  Output Compare Register A
-        typedef OCR2A OCRA;
-
-        // OCR0B  Output Compare Register B
-        typedef OCR2B OCRB;
 
-        // TIMSK0  Timer/Counter Interrupt Mask Register
-        typedef BitInRegister<TIMSK2, OCIE2B> OCIEB;
-        typedef BitInRegister<TIMSK2, OCIE2A> OCIEA;
-        typedef BitInRegister<TIMSK2, TOIE2> TOIE;
-
-        // TIFR0  Timer/Counter 0 Interrupt Flag Register
-        typedef BitInRegister<TIFR2, OCF2B> OCFB;
-        typedef BitInRegister<TIFR2, OCF2A> OCFA;
-        typedef BitInRegister<TIFR2, TOV2> TOV;
+        /**
+        @brief Clear all pending Timer2 interrupts
+        */
+        static void clearInterruptFlags() __attribute__((always_inline))
+        {
+            // Interrupt flags are cleared by writing a logical one
+            TIFR2::write(_BV(OCF2B) | _BV(OCF2A) | _BV(TOV2));
+        }
 
-        // WGM Waveform generation mode
-        struct WGM
+        /**
+        @brief Synchronize with the asynchronous clock
+        Rewrites TCCR2A and waits for the update to complete, which takes at least one TOSC1 cycle. This is required before
+        re-entering power-save mode after a wake-up by Timer2, and before reading TCNT2 after a wake-up.
+        */
+        static void synchronize()
         {
-            static void write(const WaveformGenerationMode waveformGenerationMode)
-            {
-                BitGroupInRegister<TCCR2A, WGM20, WGM21>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b11);
-                BitInRegister<TCCR2B, WGM22>::write(static_cast<uint8_t>(waveformGenerationMode) & 0b100);
-            }
-
-            static WaveformGenerationMode read()
-            {
-                uint8_t waveformGenerationMode = BitGroupInRegister<TCCR2A, WGM20, WGM21>::read();
-                if (BitInRegister<TCCR2B, WGM22>::read())
-                {
-                waveformGenerationMode |= 0b100;
-                }                
-                return static_cast<WaveformGenerationMode>(waveformGenerationMode);
-            }
-        };
+            TCCR2A::write(TCCR2A::read());
+            while (Traits::TCR2AUB_Bit::read());
+        }
+
+        private:
 
         /**
-        Compare Match A interrupt handler
+        @brief Compare Match A interrupt handler
         @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
         */
         static void handleCOMPA() __asm__("__vector_7") __attribute__((__signal__, __used__, __externally_visible__));
 
         /**
-        Compare Match B interrupt handler
+        @brief Compare Match B interrupt handler
         @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
         */
         static void handleCOMPB() __asm__("__vector_8") __attribute__((__signal__, __used__, __externally_visible__));
 
         /**
-        Overflow interrupt handler
+        @brief Overflow interrupt handler
         @note This method has to be defined in a separate cpp file. Otherwise, interrupt vector table won't be populated
         */
         static void handleOVF() __asm__("__vector_9") __attribute__((__signal__, __used__, __externally_visible__));
-        
-
     };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,210 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_TIMERFREQUENCY_H
+#define M328P_TIMERFREQUENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+namespace m328p
+{
+    ///@brief Counting sequence of a timer period
+    enum class TimerSlope : uint8_t
+    {
+        SINGLE, // Normal, CTC and fast PWM modes: One period takes TOP + 1 timer clocks
+        DUAL // Phase correct PWM modes: One period takes 2 * TOP timer clocks
+    };
+    
+    /**
+    @brief Compile-time solver for the clock selection and TOP value of a timer period
+    All prescaler settings of the timer are evaluated and the one with the lowest period error is selected. For equal errors,
+    the lower prescaler (i.e. the higher resolution) wins. Everything is evaluated at compile time.
+    Use TimerFrequency or TimerPeriod instead of this class.
+    @tparam Timer Timer driver class (Timer0, Timer1 or Timer2)
+    @tparam t_clock Timer input clock frequency in Hz (CPU clock, or 32768 for Timer2 in asynchronous mode)
+    @tparam t_cyclesNum Numerator of the target period in input clock cycles
+    @tparam t_cyclesDen Denominator of the target period in input clock cycles
+    @tparam t_tolerance Maximum relative period error in ppm
+    @tparam t_slope Counting sequence of the waveform generation mode
+    */
+    template <typename Timer, uint32_t t_clock, uint64_t t_cyclesNum, uint64_t t_cyclesDen, uint32_t t_tolerance, TimerSlope t_slope>
+    class TimerSolver
+    {
+        public:
+        
+        /**
+        @brief Get the clock selection
+        @result Clock selection with the lowest period error
+        */
+        static constexpr typename Timer::ClockSelect getClockSelect()
+        {
+            return c_solution.clockSelect;
+        }
+        
+        /**
+        @brief Get the TOP value
+        @result Value for OCRxA or ICR1, depending on the waveform generation mode
+        */
+        static constexpr typename Timer::Counter getTop()
+        {
+            return c_solution.top;
+        }
+        
+        /**
+        @brief Get the achieved period
+        @result Period in input clock cycles
+        */
+        static constexpr uint32_t getPeriodCycles()
+        {
+            return c_solution.cycles;
+        }
+        
+        /**
+        @brief Get the achieved frequency
+        @result Frequency in Hz, rounded to the nearest integer
+        */
+        static constexpr uint32_t getFrequency()
+        {
+            return (t_clock + c_solution.cycles / 2) / c_solution.cycles;
+        }
+        
+        /**
+        @brief Get the achieved period
+        @result Period in microseconds, rounded to the nearest integer
+        */
+        static constexpr uint32_t getPeriodMicroseconds()
+        {
+            return (c_solution.cycles * 1000000ULL + t_clock / 2) / t_clock;
+        }
+        
+        /**
+        @brief Get the relative period error
+        @result Relative period error in ppm
+        */
+        static constexpr uint32_t getError()
+        {
+            return c_solution.error;
+        }
+        
+        private:
+        
+        // Solver result
+        struct Solution
+        {
+            typename Timer::ClockSelect clockSelect;
+            typename Timer::Counter top;
+            uint32_t cycles;
+            uint32_t error;
+            bool valid;
+        };
+        
+        // Evaluate all prescaler settings
+        static constexpr Solution solve()
+        {
+            constexpr uint64_t maxTop = static_cast<typename Timer::Counter>(~0);
+            constexpr uint64_t slope = (t_slope == TimerSlope::DUAL) ? 2 : 1;
+            
+            Solution best = {typename Timer::ClockSelect(), 0, 0, UINT32_MAX, false};
+            
+            // All clock selection codes are evaluated, codes without prescaler (stopped, external clock) are skipped
+            for (uint8_t code = 1; code <= 7; ++code)
+            {
+                const typename Timer::ClockSelect clockSelect = static_cast<typename Timer::ClockSelect>(code);
+                const uint64_t prescaler = Timer::getPrescaler(clockSelect);
+                if (prescaler == 0)
+                {
+                    continue;
+                }
+                
+                // Timer clocks per period, rounded to the nearest integer
+                const uint64_t divisor = t_cyclesDen * prescaler * slope;
+                const uint64_t counts = (t_cyclesNum + divisor / 2) / divisor;
+                
+                // Single slope: period = TOP + 1, dual slope: period = TOP
+                if (counts < 2 || (counts - (slope == 1 ? 1 : 0)) > maxTop)
+                {
+                    continue;
+                }
+                
+                const uint64_t cycles = counts * prescaler * slope;
+                const uint64_t deviation = (cycles * t_cyclesDen > t_cyclesNum) ? (cycles * t_cyclesDen - t_cyclesNum) : (t_cyclesNum - cycles * t_cyclesDen);
+                const uint64_t error = deviation * 1000000ULL / t_cyclesNum;
+                
+                if (error < best.error)
+                {
+                    best.clockSelect = clockSelect;
+                    best.top = static_cast<typename Timer::Counter>(counts - (slope == 1 ? 1 : 0));
+                    best.cycles = static_cast<uint32_t>(cycles);
+                    best.error = static_cast<uint32_t>(error);
+                    best.valid = true;
+                }
+            }
+            
+            return best;
+        }
+        
+        static constexpr Solution c_solution = solve();
+        
+        static_assert(c_solution.valid, "Target period out of range for this timer!");
+        static_assert(!c_solution.valid || c_solution.error <= t_tolerance, "Period error exceeds tolerance!");
+    };
+    
+    /**
+    @brief Compile-time timer configuration for a target frequency
+    
+    Usage:
+    @code
+    // 1 kHz compare match rate in CTC mode
+    typedef m328p::TimerFrequency<m328p::Timer0, F_CPU, 1000> Tick;
+    
+    m328p::Timer0::init(
+    m328p::Timer0::WaveformGenerationMode::CTC,
+    Tick::getClockSelect(),
+    m328p::Timer0::CompareOutputMode::DISCONNECTED,
+    m328p::Timer0::CompareOutputMode::DISCONNECTED);
+    m328p::Timer0::writeCompareA(Tick::getTop());
+    @endcode
+    
+    @tparam Timer Timer driver class (Timer0, Timer1 or Timer2)
+    @tparam t_clock Timer input clock frequency in Hz (CPU clock, or 32768 for Timer2 in asynchronous mode)
+    @tparam t_frequency Target frequency in Hz
+    @tparam t_tolerance Maximum relative period error in ppm. Default is 1%
+    @tparam t_slope Counting sequence of the waveform generation mode
+    */
+    template <typename Timer, uint32_t t_clock, uint32_t t_frequency, uint32_t t_tolerance = 10000, TimerSlope t_slope = TimerSlope::SINGLE>
+    class TimerFrequency : public TimerSolver<Timer, t_clock, t_clock, t_frequency, t_tolerance, t_slope>
+    {
+        static_assert(t_frequency != 0, "Invalid frequency!");
+    };
+    
+    /**
+    @brief Compile-time timer configuration for a target period
+    @tparam Timer Timer driver class (Timer0, Timer1 or Timer2)
+    @tparam t_clock Timer input clock frequency in Hz (CPU clock, or 32768 for Timer2 in asynchronous mode)
+    @tparam t_periodMicroseconds Target period in microseconds
+    @tparam t_tolerance Maximum relative period error in ppm. Default is 1%
+    @tparam t_slope Counting sequence of the waveform generation mode
+    */
+    template <typename Timer, uint32_t t_clock, uint32_t t_periodMicroseconds, uint32_t t_tolerance = 10000, TimerSlope t_slope = TimerSlope::SINGLE>
+    class TimerPeriod : public TimerSolver<Timer, t_clock, static_cast<uint64_t>(t_clock) * t_periodMicroseconds, 1000000ULL, t_tolerance, t_slope>
+    {
+        static_assert(t_periodMicroseconds != 0, "Invalid period!");
+    };
+}
+
+#endif
@@ -0,0 +1,465 @@
+/*
+Copyright (C) 2022  Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef M328P_TOUCHSENSOR_H
+#define M328P_TOUCHSENSOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "m328p_ADC.h"
+#include "m328p_GPIO.h"
+#include "m328p_Atomic.h"
+
+namespace m328p
+{
+    /**
+    @brief Capacitive touch sensing using ADC charge sharing
+    Each pad is connected directly to an ADC input pin. A measurement consists of two conversions:
+    1. The pad is charged to VCC by driving its pin high, while a conversion of GND discharges the ADC sample-and-hold capacitor
+    2. The pad pin is switched to a floating input and the pad channel is converted. The charge is shared between the pad and
+    the sample-and-hold capacitor, so the result rises with the pad capacitance, i.e. when the pad is touched
+    Afterwards, the pad is discharged by driving its pin low. Idle pads are kept low to shield the measured pad.
+
+    The pads are scanned in the background by the ADC interrupt handler. Several measurements are accumulated per pad. A pad
+    is touched if its value exceeds a slowly tracking baseline by the touch threshold, and released if it falls below the
+    baseline plus the release threshold. Touch and release have to be detected in consecutive scans (debouncing).
+    While a pad is released, its baseline drifts towards the measured value by one step per drift interval, compensating
+    for slow changes of temperature and humidity. Values far below the baseline (e.g. a pad touched during calibration) and
+    touches lasting longer than the maximum on duration cause an immediate recalibration.
+
+    Usage:
+    @code
+    typedef m328p::TouchSensor<m328p::GPIOPin<m328p::Port::C, 0>, m328p::GPIOPin<m328p::Port::C, 1>> Touch;
+
+    int main()
+    {
+        Touch::init(m328p::ADConverter::PrescalerSelect::DIV_128);
+        sei();
+        Touch::start();
+
+        while (true)
+        {
+            if (Touch::isTouched(0))
+            {
+                ...
+            }
+        }
+    }
+
+    void m328p::ADConverter::handleADCInterrupt()
+    {
+        Touch::handleConversionComplete();
+    }
+    @endcode
+
+    @tparam Pads GPIOPin types of the pads. Only ADC0..ADC5 (PC0..PC5) can be used, as ADC6 and ADC7 have no digital driver.
+    The pad index is the position in this list
+    @note The ADC is used exclusively by this class
+    */
+    template <typename... Pads>
+    class TouchSensor
+    {
+        static constexpr uint8_t c_padCount = sizeof...(Pads);
+        static_assert(c_padCount > 0 && c_padCount <= 6, "TouchSensor supports 1 to 6 pads!");
+        static_assert(((Pads::getPort() == Port::C && Pads::getPinIdx() <= 5) && ...), "Pads have to be connected to ADC0..ADC5 (PC0..PC5)!");
+
+        public:
+
+        /**
+        @brief Initialization of the ADC and the pad pins. Scanning is started by start()
+        @param prescalerSelect Selected ADC clock pre-scaler
+        @param touchThreshold Value above the baseline detected as touch
+        @param releaseThreshold Value above the baseline detected as release. Should be about half the touch threshold
+        @param debounce Number of consecutive scans required to detect a touch or a release
+        @param driftInterval Number of scans per baseline drift step of released pads
+        @param maxOnDuration Number of scans after which a touched pad is recalibrated, or 0 for unlimited touch duration
+        @note Values are accumulated over getSampleCount() conversions
+        */
+        static void init(
+        const ADConverter::PrescalerSelect prescalerSelect,
+        const uint16_t touchThreshold = 40,
+        const uint16_t releaseThreshold = 20,
+        const uint8_t debounce = 2,
+        const uint8_t driftInterval = 50,
+        const uint16_t maxOnDuration = 0)
+        {
+            ADConverter::Reader<uint16_t>::init(
+            ADConverter::ReferenceSelection::AVCC,
+            prescalerSelect,
+            true,
+            false,
+            ADConverter::AutoTriggerSource::FREE_RUN,
+            usesChannel(0),
+            usesChannel(1),
+            usesChannel(2),
+            usesChannel(3),
+            usesChannel(4),
+            usesChannel(5));
+
+            (discharge<Pads>(), ...);
+
+            s_touchThreshold = touchThreshold;
+            s_releaseThreshold = releaseThreshold;
+            s_debounce = debounce;
+            s_driftInterval = driftInterval;
+            s_maxOnDuration = maxOnDuration;
+        }
+
+        /**
+        @brief Start scanning with the first pad. The baselines are calibrated by the first scan
+        */
+        static void start()
+        {
+            for (uint8_t padIdx = 0; padIdx < c_padCount; ++padIdx)
+            {
+                s_pads[padIdx] = PadState{0, 0, 0, 0, 0};
+            }
+            s_touched = 0;
+            s_calibrate = c_allPads;
+            s_scanCount = 0;
+
+            s_padIdx = 0;
+            s_sampleIdx = 0;
+            s_sum = 0;
+            s_running = true;
+            startCharge();
+        }
+
+        /**
+        @brief Stop scanning after the conversion in progress. All pads are discharged
+        */
+        static void stop()
+        {
+            s_running = false;
+        }
+
+        /**
+        @brief Recalibrate the baselines of all pads with the next scan. All pads are released
+        */
+        static void recalibrate()
+        {
+            Atomic atomic;
+            s_calibrate = c_allPads;
+            s_touched = 0;
+        }
+
+        /**
+        @brief Get the number of pads
+        @result Number of pads
+        */
+        static constexpr uint8_t getPadCount()
+        {
+            return c_padCount;
+        }
+
+        /**
+        @brief Get the number of conversions accumulated per pad and scan
+        @result Number of conversions
+        */
+        static constexpr uint8_t getSampleCount()
+        {
+            return c_sampleCount;
+        }
+
+        /**
+        @brief Check if a pad is touched
+        @param padIdx Pad index
+        @result Flag indicating the pad is touched
+        */
+        [[nodiscard]] static bool isTouched(const uint8_t padIdx)
+        {
+            return (s_touched & (1 << padIdx)) != 0;
+        }
+
+        /**
+        @brief Get the touch state of all pads
+        @result Bit mask of touched pads, bit n corresponding to pad index n
+        */
+        [[nodiscard]] static uint8_t getTouched()
+        {
+            return s_touched;
+        }
+
+        /**
+        @brief Get the number of completed scans, e.g. to wait for new values
+        @result Number of completed scans (wrapping)
+        */
+        [[nodiscard]] static uint8_t getScanCount()
+        {
+            return s_scanCount;
+        }
+
+        /**
+        @brief Get the latest value of a pad
+        @param padIdx Pad index
+        @result Sum of getSampleCount() conversions
+        */
+        [[nodiscard]] static uint16_t getValue(const uint8_t padIdx)
+        {
+            Atomic atomic;
+            return s_pads[padIdx].value;
+        }
+
+        /**
+        @brief Get the baseline of a pad
+        @param padIdx Pad index
+        @result Value of the released pad
+        */
+        [[nodiscard]] static uint16_t getBaseline(const uint8_t padIdx)
+        {
+            Atomic atomic;
+            return s_pads[padIdx].baseline;
+        }
+
+        /**
+        @brief ADC conversion complete handler
+        @note This method has to be called from ADConverter::handleADCInterrupt()
+        */
+        static void handleConversionComplete() __attribute__((always_inline))
+        {
+            const uint8_t padIdx = s_padIdx;
+
+            if (s_sharing)
+            {
+                // Charge sharing conversion of the pad completed
+                s_sum += ADConverter::Reader<uint16_t>::read();
+                dischargePad(padIdx);
+
+                if (++s_sampleIdx == c_sampleCount)
+                {
+                    evaluate(padIdx, s_sum);
+                    s_sampleIdx = 0;
+                    s_sum = 0;
+
+                    uint8_t next = padIdx + 1;
+                    if (next == c_padCount)
+                    {
+                        next = 0;
+                        s_scanCount = s_scanCount + 1;
+                    }
+                    s_padIdx = next;
+                }
+
+                if (s_running)
+                {
+                    startCharge();
+                }
+            }
+            else
+            {
+                // Pad charged and sample-and-hold capacitor discharged. The pad is left floating and shares its charge
+                releasePad(padIdx);
+                ADConverter::selectChannel(static_cast<ADConverter::ChannelSelection>(c_channels[padIdx]));
+                ADConverter::startConversion();
+                s_sharing = true;
+            }
+        }
+
+        private:
+
+        // Number of conversions accumulated per pad and scan
+        static constexpr uint8_t c_sampleCount = 4;
+
+        // ADC channels of the pads
+        static constexpr uint8_t c_channels[c_padCount] = {Pads::getPinIdx()...};
+
+        // Bit mask of all pads
+        static constexpr uint8_t c_allPads = (1 << c_padCount) - 1;
+
+        // Measurement state of a pad
+        struct PadState
+        {
+            uint16_t value; // Latest value
+            uint16_t baseline; // Value of the released pad
+            uint16_t onDuration; // Number of scans the pad has been touched
+            uint8_t debounce; // Number of consecutive scans with a pending state change
+            uint8_t drift; // Number of scans since the last baseline drift step
+        };
+
+        // Check if a given ADC input channel is used by a pad
+        static constexpr bool usesChannel(const uint8_t channel)
+        {
+            return ((Pads::getPinIdx() == channel) || ...);
+        }
+
+        // Drive the pad high
+        template <typename Pad>
+        static void charge()
+        {
+            Pad::high();
+            Pad::setAsOutput();
+        }
+
+        // Switch the pad to a floating input
+        template <typename Pad>
+        static void release()
+        {
+            Pad::setAsInput();
+            Pad::low();
+        }
+
+        // Drive the pad low
+        template <typename Pad>
+        static void discharge()
+        {
+            Pad::low();
+            Pad::setAsOutput();
+        }
+
+        // Drive the pad with the given index high
+        static void chargePad(const uint8_t padIdx) __attribute__((always_inline))
+        {
+            uint8_t idx = 0;
+            ((idx++ == padIdx ? charge<Pads>() : void()), ...);
+        }
+
+        // Switch the pad with the given index to a floating input
+        static void releasePad(const uint8_t padIdx) __attribute__((always_inline))
+        {
+            uint8_t idx = 0;
+            ((idx++ == padIdx ? release<Pads>() : void()), ...);
+        }
+
+        // Drive the pad with the given index low
+        static void dischargePad(const uint8_t padIdx) __attribute__((always_inline))
+        {
+            uint8_t idx = 0;
+            ((idx++ == padIdx ? discharge<Pads>() : void()), ...);
+        }
+
+        // Charge the current pad while a conversion of GND discharges the sample-and-hold capacitor
+        static void startCharge() __attribute__((always_inline))
+        {
+            chargePad(s_padIdx);
+            ADConverter::selectChannel(ADConverter::ChannelSelection::GND);
+            ADConverter::startConversion();
+            s_sharing = false;
+        }
+
+        // Touch detection and baseline tracking of a pad
+        static void evaluate(const uint8_t padIdx, const uint16_t value)
+        {
+            PadState& pad = s_pads[padIdx];
+            const uint8_t mask = 1 << padIdx;
+            pad.value = value;
+
+            if (s_calibrate & mask)
+            {
+                s_calibrate = s_calibrate & ~mask;
+                pad.baseline = value;
+                pad.debounce = 0;
+                pad.drift = 0;
+                return;
+            }
+
+            const int16_t delta = static_cast<int16_t>(value - pad.baseline);
+
+            if (s_touched & mask)
+            {
+                if (delta < static_cast<int16_t>(s_releaseThreshold))
+                {
+                    if (++pad.debounce >= s_debounce)
+                    {
+                        s_touched = s_touched & ~mask;
+                        pad.debounce = 0;
+                        pad.drift = 0;
+                    }
+                }
+                else
+                {
+                    pad.debounce = 0;
+                }
+
+                if (s_maxOnDuration != 0 && ++pad.onDuration >= s_maxOnDuration)
+                {
+                    // Touch lasting too long, e.g. an object placed on the pad
+                    s_touched = s_touched & ~mask;
+                    pad.baseline = value;
+                    pad.debounce = 0;
+                }
+            }
+            else if (delta > static_cast<int16_t>(s_touchThreshold))
+            {
+                if (++pad.debounce >= s_debounce)
+                {
+                    s_touched = s_touched | mask;
+                    pad.debounce = 0;
+                    pad.onDuration = 0;
+                }
+            }
+            else
+            {
+                pad.debounce = 0;
+
+                if (delta < -static_cast<int16_t>(s_releaseThreshold))
+                {
+                    // Value far below the baseline. The pad has been touched during calibration
+                    pad.baseline = value;
+                    pad.drift = 0;
+                }
+                else if (++pad.drift >= s_driftInterval)
+                {
+                    pad.drift = 0;
+                    if (delta > 0)
+                    {
+                        ++pad.baseline;
+                    }
+                    else if (delta < 0)
+                    {
+                        --pad.baseline;
+                    }
+                }
+            }
+        }
+
+        // Measurement states of the pads
+        inline static PadState s_pads[c_padCount];
+
+        // Bit mask of touched pads
+        inline static volatile uint8_t s_touched = 0;
+
+        // Bit mask of pads to be calibrated by the next scan
+        inline static volatile uint8_t s_calibrate = 0;
+
+        // Number of completed scans
+        inline static volatile uint8_t s_scanCount = 0;
+
+        // Detection parameters
+        inline static uint16_t s_touchThreshold = 0;
+        inline static uint16_t s_releaseThreshold = 0;
+        inline static uint16_t s_maxOnDuration = 0;
+        inline static uint8_t s_debounce = 0;
+        inline static uint8_t s_driftInterval = 0;
+
+        // Index of the pad being measured
+        inline static uint8_t s_padIdx = 0;
+
+        // Number of conversions accumulated for the current pad
+        inline static uint8_t s_sampleIdx = 0;
+
+        // Sum of conversions of the current pad
+        inline static uint16_t s_sum = 0;
+
+        // Flag indicating the charge sharing conversion is in progress. Otherwise the pad is being charged
+        inline static bool s_sharing = false;
+
+        // Flag indicating the scan continues after the conversion in progress
+        inline static volatile bool s_running = false;
+    };
+}
+
+#endif
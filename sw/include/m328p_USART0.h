@@ -81,6 +81,15 @@ namespace m328p
             UDR::write(data);
         }
 
+        /**
+        @brief Check if the transmit buffer is ready to receive new data
+        @result Flag indicating the USART data register is empty
+        */
+        [[nodiscard]] static bool isReadyToTransmit()
+        {
+            return UDRE_Bit::read();
+        }
+
         /**
         @brief Receive one Byte of data
         @result Received data byte
@@ -0,0 +1,128 @@
+/*
+Copyright (C) 2022 Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+@brief Benchmark for DSP kernels
+Connect a serial terminal (38400 8N1) to TXD (PD1)
+
+Each kernel processes a block of 64 right-aligned 10-bit samples 100 times. The profiler statistics are transmitted once
+in the format "<kernel> <count> <min> <max> <total>" (CPU cycles per block). Cycles per sample = min / 64
+0: FIR, 16 taps, Q15
+1: FIR, 16 taps, Q7
+2: Biquad, Q15
+3: Running average, 16 samples
+4: CIC, 3 stages, decimation by 8
+*/
+
+#include "m328p_SystemClock.h"
+#include "m328p_Profiler.h"
+#include "m328p_USART0.h"
+#include "m328p_DSP.h"
+#include <stdbool.h>
+
+/// Cycle counter
+typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_1> Clock;
+
+/// Profiled kernels
+enum Kernel : uint8_t {FIR_Q15, FIR_Q7, BIQUAD, RUNNING_AVERAGE, CIC, KERNEL_COUNT};
+
+/// Profiler
+typedef m328p::Profiler<Clock, KERNEL_COUNT> Profiler;
+
+/// Block size
+static constexpr uint8_t c_blockSize = 64;
+
+/// Low-pass filter coefficients
+static const int16_t c_coefficientsQ15[16] = {-155, -322, -184, 657, 2203, 3936, 5183, 5640, 5183, 3936, 2203, 657, -184, -322, -155, 0};
+static const int8_t c_coefficientsQ7[16] = {-1, -1, -1, 3, 9, 15, 20, 22, 20, 15, 9, 3, -1, -1, -1, 0};
+
+/// Kernels under test
+static m328p::FIR<int16_t, 16> firQ15(c_coefficientsQ15);
+static m328p::FIR<int8_t, 16> firQ7(c_coefficientsQ7);
+static m328p::Biquad biquad({1105, 2210, 1105, -18727, 6764});
+static m328p::RunningAverage<uint16_t, 16> runningAverage;
+static m328p::CIC<uint16_t, 3, 8> cic;
+
+/// Input and output blocks
+static uint16_t input[c_blockSize];
+static int16_t outputQ15[c_blockSize];
+static int8_t outputQ7[c_blockSize];
+static uint16_t output[c_blockSize];
+
+/// main function
+int main(void)
+{
+    m328p::USART0::init(
+    F_CPU,
+    38400,
+    true,
+    false,
+    false,
+    false,
+    false,
+    m328p::USART0::Mode::ASYNC,
+    m328p::USART0::CharacterSize::_8,
+    m328p::USART0::Parity::NONE,
+    m328p::USART0::StopBits::_1,
+    m328p::USART0::ClockPolarity::OUT_RISING_IN_FALLING);
+
+    Clock::init();
+    sei();
+    Profiler::init();
+
+    // Saw tooth test signal
+    for (uint8_t idx = 0; idx < c_blockSize; ++idx)
+    {
+        input[idx] = static_cast<uint16_t>(idx) << 4;
+    }
+
+    for (uint8_t cnt = 0; cnt < 100; ++cnt)
+    {
+        {
+            m328p::ScopedProfile<Profiler, FIR_Q15> profile;
+            firQ15.process(input, outputQ15, c_blockSize);
+        }
+        {
+            m328p::ScopedProfile<Profiler, FIR_Q7> profile;
+            firQ7.process(input, outputQ7, c_blockSize);
+        }
+        {
+            m328p::ScopedProfile<Profiler, BIQUAD> profile;
+            biquad.process(input, outputQ15, c_blockSize);
+        }
+        {
+            m328p::ScopedProfile<Profiler, RUNNING_AVERAGE> profile;
+            runningAverage.process(input, output, c_blockSize);
+        }
+        {
+            m328p::ScopedProfile<Profiler, CIC> profile;
+            cic.process(input, output, c_blockSize);
+        }
+    }
+
+    Profiler::dump();
+
+    while (1)
+    {
+    }
+}
+
+/// ISR for Timer1 overflow interrupt
+void m328p::Timer1::handleOVF()
+{
+    Clock::handleOverflow();
+}
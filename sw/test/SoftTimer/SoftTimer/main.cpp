@@ -0,0 +1,142 @@
+/*
+Copyright (C) 2022 Andreas Lagler
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+@brief Test for SoftTimerService class
+Connect LEDs to PB0:3, connect an oscilloscope to PB4
+
+LEDs should blink independently
+PB0 toggles every 100 ms
+PB1 toggles every 250 ms
+PB2 toggles every 1 s for 10 s (one-shot timer restarted from its own callback), then stays off
+PB3 toggles every 200 ms (one-shot timer restarted from its own callback, deadline between 0x8000 and 0xFFFF ticks ahead)
+PB4 is toggled continuously by the main loop. There must be no gaps in the square wave other than the short interrupt handlers
+
+@note Prerequisites: GPIO Test passed
+*/
+
+#include "m328p_SystemClock.h"
+#include "m328p_SoftTimer.h"
+#include "m328p_GPIO.h"
+#include <stdbool.h>
+
+/// System clock with 4 us resolution at 16 MHz
+typedef m328p::SystemClock<F_CPU, m328p::Timer1::ClockSelect::PRESCALER_64> Clock;
+
+/// Software timer service
+typedef m328p::SoftTimerService<Clock> Timers;
+
+/// Output pin definitions
+typedef m328p::GPIOPin<m328p::Port::B, 0> OutputPin0;
+typedef m328p::GPIOPin<m328p::Port::B, 1> OutputPin1;
+typedef m328p::GPIOPin<m328p::Port::B, 2> OutputPin2;
+typedef m328p::GPIOPin<m328p::Port::B, 3> OutputPin3;
+typedef m328p::GPIOPin<m328p::Port::B, 4> OutputPin4;
+
+/// 200 ms = 50000 ticks, beyond the signed 16-bit range of the compare register
+static constexpr Clock::Ticks c_delay3 = Clock::toTicks(200000);
+static_assert(c_delay3 > 0x7FFF && c_delay3 <= 0xFFFF, "Delay of timer 3 has to be between 0x8000 and 0xFFFF ticks!");
+
+/// Timer callbacks
+static void toggle0();
+static void toggle1();
+static void toggle2();
+static void toggle3();
+
+/// Software timers
+static m328p::SoftTimer timer0(toggle0);
+static m328p::SoftTimer timer1(toggle1);
+static m328p::SoftTimer timer2(toggle2);
+static m328p::SoftTimer timer3(toggle3);
+
+/// main function
+int main(void)
+{
+    OutputPin0::setAsOutput();
+    OutputPin1::setAsOutput();
+    OutputPin2::setAsOutput();
+    OutputPin3::setAsOutput();
+    OutputPin4::setAsOutput();
+    
+    Clock::init();
+    
+    sei();
+    
+    Timers::start(timer0, Clock::toTicks(100000), Clock::toTicks(100000));
+    Timers::start(timer1, Clock::toTicks(250000), Clock::toTicks(250000));
+    Timers::start(timer2, Clock::toTicks(1000000));
+    Timers::start(timer3, c_delay3);
+    
+    while (1)
+    {
+        OutputPin4::high();
+        OutputPin4::low();
+    }
+}
+
+static void toggle0()
+{
+    static bool pinState = 1;
+    OutputPin0::write(pinState);
+    pinState = !pinState;
+}
+
+static void toggle1()
+{
+    static bool pinState = 1;
+    OutputPin1::write(pinState);
+    pinState = !pinState;
+}
+
+static void toggle2()
+{
+    static bool pinState = 1;
+    static uint8_t count = 0;
+    OutputPin2::write(pinState);
+    pinState = !pinState;
+    
+    if (++count < 10)
+    {
+        Timers::start(timer2, Clock::toTicks(1000000));
+    }
+    else
+    {
+        OutputPin2::low();
+    }
+}
+
+static void toggle3()
+{
+    static bool pinState = 1;
+    OutputPin3::write(pinState);
+    pinState = !pinState;
+    
+    Timers::start(timer3, c_delay3);
+}
+
+/// ISR for Timer1 overflow interrupt
+void m328p::Timer1::handleOVF()
+{
+    Clock::handleOverflow();
+    Timers::handleOverflow();
+}
+
+/// ISR for Timer1 compare match A interrupt
+void m328p::Timer1::handleCOMPA()
+{
+    Timers::handleCompareMatch();
+}